@@ -0,0 +1,107 @@
+// Copyright Daniel Morilha 2025
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+/*
+ * compares parsing csi parameters the way vt100 used to, collecting the
+ * sequence into a vector and splitting it into a vector of integers, to the
+ * allocation free parser::Sequence.
+ */
+namespace {
+
+constexpr std::size_t ITERATIONS = 200000;
+
+const std::string STREAM =
+  "\e[1;31m" "\e[38;5;208m" "\e[0m" "\e[38;2;10;20;30m" "\e[48;2;200;100;50m"
+  "\e[?1049h" "\e[12;40H" "\e[4:3m" "\e[K" "\e[0;1;4;7;38;5;33;48;5;236m";
+
+/* the sequence bytes between '[' and the final byte */
+template <typename Parse>
+auto run(Parse && parse) -> uint64_t {
+  uint64_t checksum = 0;
+  for (std::size_t i = 0; ITERATIONS > i; ++i) {
+    for (std::size_t j = 0; STREAM.size() > j; ++j) {
+      if ('\e' != STREAM[j]) {
+        continue;
+      }
+      std::size_t k = j + 2;
+      for (; '@' > STREAM[k]; ++k) { }
+      checksum += parse(STREAM.data() + j + 2, STREAM.data() + k);
+      j = k;
+    }
+  }
+  return checksum;
+}
+
+auto legacy(const char * iterator, const char * const end) -> uint64_t {
+  std::vector<char> sequence;
+  for (; end != iterator; ++iterator) {
+    sequence.push_back(*iterator);
+  }
+  sequence.push_back('\0');
+
+  std::vector<int> codes;
+  const char * start = sequence.data();
+  if ('?' == *start) {
+    ++start;
+  }
+  while ('\0' != *start) {
+    codes.push_back(std::atoi(start));
+    while ('\0' != *start && ';' != *start && ':' != *start) {
+      ++start;
+    }
+    if ('\0' != *start) {
+      ++start;
+    }
+  }
+
+  uint64_t sum = 0;
+  for (const int code : codes) {
+    sum += code;
+  }
+  return sum;
+}
+
+parser::Sequence sequence;
+
+auto incremental(const char * iterator, const char * const end) -> uint64_t {
+  sequence.clear();
+  for (; end != iterator; ++iterator) {
+    if ('<' <= *iterator && '?' >= *iterator) {
+      sequence.collect(*iterator);
+    } else {
+      sequence.parameters.add(*iterator);
+    }
+  }
+
+  uint64_t sum = 0;
+  for (std::size_t i = 0; sequence.parameters.size() > i; ++i) {
+    sum += sequence.parameters[i];
+  }
+  return sum;
+}
+
+template <typename Parse>
+auto measure(const char * const name, Parse && parse) -> uint64_t {
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t checksum = run(parse);
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  const double sequences = ITERATIONS * 10;
+  std::cout << name << ": " << static_cast<uint64_t>(sequences / elapsed.count())
+    << " sequences/s (checksum " << checksum << ")" << std::endl;
+  return checksum;
+}
+
+} // end of annonymous namespace
+
+int main() {
+  const uint64_t before = measure("vector", legacy);
+  const uint64_t after = measure("parser::Sequence", incremental);
+  return before == after ? EXIT_SUCCESS : EXIT_FAILURE;
+}
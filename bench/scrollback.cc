@@ -0,0 +1,65 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "chunked.h"
+#include "scrollback.h"
+
+/*
+ * append latency as history grows. appends are timed in batches of BATCH
+ * and percentiles are given for every doubling of the history, a vector
+ * copying itself as it grows shows in the tail, chunked tables stay flat.
+ */
+namespace {
+
+constexpr std::size_t BATCH = 1024;
+constexpr std::size_t FIRST = 1 << 16;
+constexpr std::size_t TABLES = 1 << 24;
+constexpr std::size_t RUNES = 1 << 26;
+
+template <typename Append>
+auto measure(const char * const name, const std::size_t last, Append && append) -> void {
+  std::cout << name << ":" << std::endl;
+  std::vector<uint64_t> samples;
+  std::size_t size = 0;
+  for (std::size_t end = FIRST; last >= end; end *= 2) {
+    samples.clear();
+    for (; end > size; size += BATCH) {
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; BATCH > i; ++i) {
+        append(size + i);
+      }
+      const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+      samples.push_back(elapsed.count());
+    }
+    std::sort(samples.begin(), samples.end());
+    std::cout << "  " << end << " appends, per batch of " << BATCH
+      << ": p50 " << samples[samples.size() / 2]
+      << " ns, p99 " << samples[samples.size() * 99 / 100]
+      << " ns, max " << samples.back() << " ns" << std::endl;
+  }
+}
+
+} // end of annonymous namespace
+
+int main() {
+  {
+    std::vector<uint64_t> table;
+    measure("std::vector", TABLES, [&](const std::size_t i) { table.push_back(i); });
+  }
+  {
+    Chunked<uint64_t> table;
+    measure("Chunked", TABLES, [&](const std::size_t i) { table.push_back(i); });
+  }
+  {
+    Scrollback scrollback;
+    measure("Scrollback", RUNES, [&](const std::size_t i) {
+      scrollback.push_back(rune::Rune(0 == (i + 1) % 80 ? L'\n' : L'a' + i % 26));
+    });
+  }
+  return EXIT_SUCCESS;
+}
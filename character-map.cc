@@ -17,7 +17,7 @@ const Character & CharacterMap::retrieve(const rune::Rune & rune) {
   if ( ! found) {
     Character & character = map_[rune];
     freetype::Glyph glyph;
-    switch (rune.style) {
+    switch (rune.style()) {
     case rune::Style::REGULAR:
       glyph = font_.regular().glyph(rune.character);
       break;
@@ -0,0 +1,82 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <compare>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * append only sequence kept in chunks of N elements which never move.
+ * growing allocates one more chunk rather than copying everything so far,
+ * only the table of chunks is ever copied, N times smaller, and elements
+ * stay where they are. clearing frees whole chunks.
+ */
+template <typename T, std::size_t N = 4096>
+class Chunked {
+  static_assert(0 < N && 0 == (N & (N - 1)), "chunk size must be a power of two");
+
+public:
+  class Iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using pointer = const T *;
+    using reference = const T &;
+
+    Iterator() = default;
+
+    auto operator * () const -> reference { return (*chunked_)[index_]; }
+    auto operator -> () const -> pointer { return &(*chunked_)[index_]; }
+    auto operator [] (const difference_type n) const -> reference { return (*chunked_)[index_ + n]; }
+    auto operator ++ () -> Iterator & { ++index_; return *this; }
+    auto operator ++ (int) -> Iterator { Iterator i = *this; ++index_; return i; }
+    auto operator -- () -> Iterator & { --index_; return *this; }
+    auto operator -- (int) -> Iterator { Iterator i = *this; --index_; return i; }
+    auto operator += (const difference_type n) -> Iterator & { index_ += n; return *this; }
+    auto operator -= (const difference_type n) -> Iterator & { index_ -= n; return *this; }
+    auto operator + (const difference_type n) const -> Iterator { Iterator i = *this; return i += n; }
+    auto operator - (const difference_type n) const -> Iterator { Iterator i = *this; return i -= n; }
+    auto operator - (const Iterator & o) const -> difference_type { return index_ - o.index_; }
+    auto operator == (const Iterator & o) const -> bool { return index_ == o.index_; }
+    auto operator <=> (const Iterator & o) const -> std::strong_ordering { return index_ <=> o.index_; }
+
+    friend auto operator + (const difference_type n, const Iterator & i) -> Iterator { return i + n; }
+
+  private:
+    Iterator(const Chunked & chunked, const std::size_t index) : chunked_(&chunked), index_(index) { }
+
+    const Chunked * chunked_ = nullptr;
+    std::size_t index_ = 0;
+
+    friend class Chunked;
+  };
+
+  auto operator [] (const std::size_t i) -> T & { return chunks_[i / N][i % N]; }
+  auto operator [] (const std::size_t i) const -> const T & { return chunks_[i / N][i % N]; }
+
+  auto back() -> T & { return (*this)[size_ - 1]; }
+  auto back() const -> const T & { return (*this)[size_ - 1]; }
+  auto begin() const -> Iterator { return Iterator(*this, 0); }
+  auto end() const -> Iterator { return Iterator(*this, size_); }
+  /* elements allocated, a multiple of N */
+  auto capacity() const -> std::size_t { return chunks_.size() * N; }
+  auto clear() -> void { chunks_.clear(); size_ = 0; }
+  auto empty() const -> bool { return 0 == size_; }
+  auto push_back(const T & t) -> void {
+    if (capacity() == size_) {
+      chunks_.push_back(std::make_unique_for_overwrite<T[]>(N));
+    }
+    (*this)[size_++] = t;
+  }
+  auto size() const -> std::size_t { return size_; }
+
+private:
+  std::vector<std::unique_ptr<T[]>> chunks_;
+  std::size_t size_ = 0;
+};
@@ -0,0 +1,32 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * the widest instruction set available at run time, checked once, so code
+ * built for the baseline can pick its vectorized implementations.
+ */
+namespace cpu {
+
+enum class Level : uint8_t {
+  SCALAR,
+  SSE2,
+  AVX2,
+};
+
+inline auto level() -> Level {
+#if defined(__SSE2__)
+  static const Level level = [] {
+    /* may run from static initializers, before main */
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? Level::AVX2 : Level::SSE2;
+  }();
+  return level;
+#else
+  return Level::SCALAR;
+#endif
+}
+
+} // end of namespace cpu
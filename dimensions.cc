@@ -113,20 +113,24 @@ void Dimensions::cursor_line(const uint16_t v) {
   }
 }
 
-void Dimensions::reset(freetype::Face & face, const uint16_t width, const uint16_t height) {
+void Dimensions::reset(const int16_t descender, const uint16_t glyph_width, const uint16_t line_height, const uint16_t width, const uint16_t height) {
   assert(0 < width);
   assert(0 < height);
   surface_width_ = width;
   surface_height_ = height;
 
-  glyph_descender_ = face.descender();
+  glyph_descender_ = descender;
 
-  assert(0 < face.lineHeight());
-  line_height_ = face.lineHeight();
+  assert(0 < line_height);
+  line_height_ = line_height;
 
-  assert(0 < face.glyphWidth());
-  glyph_width_ = face.glyphWidth();
+  assert(0 < glyph_width);
+  glyph_width_ = glyph_width;
 
+  rewind();
+}
+
+void Dimensions::rewind() {
   cursor_column_ = cursor_line_ = displayed_lines_ = 1;
   overflow_ = wrap_next_ = false;
   scroll_y_ = scrollback_lines_ = 0;
@@ -6,7 +6,6 @@
 
 #include <cassert>
 
-#include "freetype.h"
 #include "types.h"
 
 class Dimensions {
@@ -19,6 +18,8 @@ public:
 
   auto area() const -> uint32_t { return surface_width_ * surface_height_; }
   auto backspace() -> void;
+  /* scroll region, the whole screen unless margins were set */
+  auto bottom_margin() const -> uint16_t { return 0 < bottom_margin_ ? bottom_margin_ : lines(); }
   auto cursor_column() const { return cursor_column_; }
   auto cursor_column(const uint16_t) -> void;
   auto cursor_line() const { return cursor_line_; }
@@ -31,17 +32,24 @@ public:
   auto glyph_descender(const auto v) { glyph_descender_ = v; }
   auto glyph_width() const { return glyph_width_; }
   auto glyph_width(const auto v) { glyph_width_ = v; }
+  auto has_margins() const { return 0 < bottom_margin_; }
   auto line_height() const { return line_height_; }
   auto line_height(const auto v) { line_height_ = v; }
+  /* 0, 0 for the whole screen */
+  auto margins(const uint16_t top, const uint16_t bottom) { top_margin_ = top; bottom_margin_ = bottom; }
   auto move_cursor(const uint16_t, const uint16_t) -> void;
   auto new_line() -> bool;
   auto overflow() const { return enable_overflow_ && overflow_; }
-  auto reset(freetype::Face & face, const uint16_t, const uint16_t) -> void;
+  /* font metrics (descender, glyph width and line height) and surface size */
+  auto reset(const int16_t, const uint16_t, const uint16_t, const uint16_t, const uint16_t) -> void;
+  /* back to the top of an empty canvas, keeping metrics, size and margins */
+  auto rewind() -> void;
   auto scroll_y() const { return scroll_y_; }
   auto scroll_y(const auto v) { scroll_y_ = v; }
   auto scrollback_lines() const { return scrollback_lines_; }
   auto surface_height() const { return surface_height_; }
   auto surface_width() const { return surface_width_; }
+  auto top_margin() const -> uint16_t { return 0 < top_margin_ ? top_margin_ : 1; }
   auto wrap_next() const { return wrap_next_; }
 
   explicit operator Rectangle () const;
@@ -117,6 +125,9 @@ private:
 
   uint64_t scroll_y_ = 0; // pixels
 
+  uint16_t top_margin_ = 0; // scroll region, 0 when it is the whole screen
+  uint16_t bottom_margin_ = 0;
+
   uint16_t displayed_lines_ = 1; // 65k it goes 1 up to a ... ~thousand
   uint64_t scrollback_lines_ = 0; // memory is the limit really.
   bool overflow_ = false; // whether the cursor reached the end of the screen.
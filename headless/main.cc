@@ -0,0 +1,187 @@
+// Copyright Daniel Morilha 2025
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <clocale>
+#include <cstdlib>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "poller.h"
+#include "recording.h"
+#include "screen.h"
+#include "terminal.h"
+
+/*
+ * runs the vt100 -> Screen -> History pipeline without a compositor, over
+ * either a recording or whatever arrives on stdin, then reports throughput
+ * and the checksum of the final grid.
+ */
+
+using namespace std::chrono_literals;
+
+/* repaints at the same pace as the wayland poller */
+struct Frames : public Events {
+  Frames(std::function<void ()> && r) : Events(16ms, true), repaint_(std::move(r)) { }
+  void timeout() override { repaint_(); }
+private:
+  std::function<void ()> repaint_;
+};
+
+int main(int argc, char ** argv) {
+  setlocale(LC_CTYPE, "en_US.UTF-8");
+
+  Terminal::Options options;
+  Screen::JumpScroll jump_scroll;
+  std::optional<spill::Options> spill;
+  std::size_t index = 0;
+  uint16_t columns = 80, lines = 24;
+  std::string replay;
+  double speed = 0;
+  bool dump = false;
+  for (int i = 1; argc > i; ++i) {
+    const std::string_view argument{argv[i]};
+    const bool has_value = argc > i + 1;
+    if ("--threaded" == argument) {
+      options.threaded = true;
+    } else if ("--columns" == argument && has_value) {
+      columns = std::atoi(argv[++i]);
+    } else if ("--lines" == argument && has_value) {
+      lines = std::atoi(argv[++i]);
+    } else if ("--buffer" == argument && has_value) {
+      options.buffer = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--backlog" == argument && has_value) {
+      options.backlog = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--jump-scroll" == argument && has_value) {
+      jump_scroll.screens = std::atoi(argv[++i]);
+    } else if ("--spill" == argument && has_value) {
+      spill.emplace().memory = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--spill-quota" == argument && has_value && spill.has_value()) {
+      spill->disk = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--spill-directory" == argument && has_value && spill.has_value()) {
+      spill->directory = argv[++i];
+    } else if ("--index" == argument && has_value) {
+      index = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--replay" == argument && has_value) {
+      replay = argv[++i];
+    } else if ("--speed" == argument && has_value) {
+      const std::string_view value{argv[++i]};
+      speed = "max" == value ? 0 : std::atof(argv[i]);
+    } else if ("--dump" == argument) {
+      /* prints the final grid */
+      dump = true;
+    } else {
+      std::cerr << "usage: " << argv[0]
+        << " [--threaded] [--buffer bytes] [--backlog bytes] [--jump-scroll screens] [--spill bytes [--spill-quota bytes] [--spill-directory path]] [--index bytes] [--columns n] [--lines n] [--replay file [--speed max|factor]] [--dump] < input" << std::endl;
+      return 1;
+    }
+  }
+
+  if (0 == columns || 0 == lines) {
+    std::cerr << "invalid grid size" << std::endl;
+    return 1;
+  }
+
+  Screen screen = Screen::Headless(columns, lines);
+  screen.jump_scroll(jump_scroll);
+  if (spill.has_value()) {
+    screen.spill(*spill);
+  }
+  if (0 < index) {
+    screen.trigrams(index);
+  }
+
+  int sockets[2] = {-1, -1};
+  if (0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets)) {
+    std::cerr << "failed to create socket pair" << std::endl;
+    return 1;
+  }
+
+  recording::Report report;
+  std::optional<recording::Player> player;
+  std::thread input;
+  std::atomic<uint64_t> bytes = 0;
+  if ( ! replay.empty()) {
+    player.emplace(replay, speed, sockets[1]);
+  } else {
+    /* copies stdin verbatim */
+    input = std::thread([&bytes, fd = sockets[1]]() {
+      std::array<char, 65536> buffer;
+      ssize_t size = 0;
+      while (0 < (size = read(STDIN_FILENO, buffer.data(), buffer.size()))) {
+        for (ssize_t offset = 0; size > offset; ) {
+          const ssize_t result = write(fd, buffer.data() + offset, size - offset);
+          if (0 > result) {
+            return;
+          }
+          offset += result;
+        }
+        bytes += size;
+      }
+      shutdown(fd, SHUT_WR);
+    });
+  }
+
+  /* times the repaints which present a frame */
+  const auto repaint = [&]() {
+    const uint64_t frames = screen.frames();
+    const auto start = std::chrono::steady_clock::now();
+    screen.repaint();
+    if (frames != screen.frames()) {
+      report.frame(std::chrono::steady_clock::now() - start);
+    }
+  };
+
+  Poller poller(16ms);
+  auto t = Terminal::Replay(screen, sockets[0], options);
+  const int fd = t->pollfd();
+  Terminal & terminal = poller.add(fd, std::move(t));
+  poller.add(-1, std::make_unique<Frames>(repaint));
+
+  terminal.onHangup = [&]() {
+    if (poller.is_running()) {
+      repaint();
+      poller.off();
+    }
+  };
+
+  poller.on();
+  poller.poll();
+
+  if (input.joinable()) {
+    input.join();
+  }
+
+  report.bytes = player.has_value() ? player->bytes() : bytes.load();
+  report.checksum = screen.checksum();
+  std::cout << report << std::endl
+    << terminal.reads() << std::endl
+    << screen.jumps() << std::endl
+    << rune::AttributesTable::size() << " attributes interned" << std::endl;
+  if (0 < index) {
+    std::cout << screen.indexed() << std::endl;
+  }
+
+  if (dump) {
+    for (uint16_t line = 1; lines >= line; ++line) {
+      std::string row;
+      for (uint16_t column = 1; columns >= column; ++column) {
+        const rune::Rune & rune = screen.at(column, line);
+        row += static_cast<bool>(rune) && ! rune.iscontrol() ? static_cast<std::string>(rune) : " ";
+      }
+      std::cout << row << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+// Copyright Daniel Morilha 2025
+
+#include <cassert>
+
+#include "screen.h"
+
+/*
+ * the headless backend, nothing is drawn nor presented. the screen still
+ * drives History and Dimensions exactly as it does with a surface, using
+ * fixed font metrics, so parsing and layout can be exercised and measured
+ * without a compositor.
+ */
+namespace {
+constexpr uint16_t GLYPH_WIDTH = 8;
+constexpr uint16_t LINE_HEIGHT = 16;
+} // end of annonymous namespace
+
+struct Screen::Backend { };
+
+Screen Screen::Headless(const uint16_t columns, const uint16_t lines) {
+  assert(0 < columns);
+  assert(0 < lines);
+  Screen screen(std::make_unique<Backend>());
+  screen.resize(columns * GLYPH_WIDTH, lines * LINE_HEIGHT);
+  return screen;
+}
+
+Screen::Screen(std::unique_ptr<Backend> && backend) : backend_(std::move(backend)) { }
+
+Screen::Screen(Screen && other) : backend_(std::move(other.backend_)),
+  dimensions_(other.dimensions_), history_(std::move(other.history_)) { }
+
+Screen::~Screen() = default;
+
+void Screen::setTitle(const std::string &) { }
+
+void Screen::show_title(const std::string &) { }
+
+void Screen::changeScrollY(int32_t) { }
+
+void Screen::reset(const uint16_t width, const uint16_t height) {
+  dimensions_.reset(0, GLYPH_WIDTH, LINE_HEIGHT, width, height);
+}
+
+void Screen::clear() { }
+
+void Screen::draw_blank(const uint16_t, const int) { }
+
+void Screen::draw_matches(const int64_t) const { }
+
+void Screen::draw_scrollback() { }
+
+void Screen::draw_scroll(const uint16_t, const uint16_t, const int) { }
+
+void Screen::draw_shift(const uint16_t, const int) { }
+
+void Screen::swap_pages(const bool) { }
+
+void Screen::present(const bool, const bool) {
+  ++frames_;
+}
+
+void Screen::draw_active_history() { }
+
+void Screen::draw_erase_line_right() { }
+
+void Screen::new_line() { }
+
+uint16_t Screen::pushCharacter(rune::Rune rune) {
+  if (L'\t' == rune.character) {
+    return 8 - (column() % 8);
+  }
+  return 1;
+}
+
+void Screen::pushCharacters(std::span<const rune::Rune>) { }
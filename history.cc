@@ -1,6 +1,9 @@
 // Copyright Daniel Morilha 2025
 
 #include <algorithm>
+#include <array>
+
+#include <cstdlib>
 
 #include "history.h"
 
@@ -30,17 +33,10 @@ void History::emplace(rune::Rune rune) {
     }
   }
 
-  if (0 < long_transaction_) {
-    ++long_transaction_;
-  }
-
   ++last_;
 
   if (0 == last_ % columns_) {
-    last_ %= active_.size();
-    if (first_ == last_) {
-      scrollback();
-    }
+    wrap();
     ++last_;
   }
 
@@ -63,6 +59,127 @@ void History::emplace(rune::Rune rune) {
   assert(0 < active_size_);
 }
 
+/*
+ * emplaces printable runes (no control characters), copying them one row
+ * segment at a time.
+ */
+void History::emplace_run(std::span<const rune::Rune> runes) {
+  assert(0 < columns_);
+
+  while ( ! runes.empty()) {
+    ++last_;
+
+    if (0 == last_ % columns_) {
+      wrap();
+      ++last_;
+    }
+
+    const uint32_t length = std::min<uint32_t>(runes.size(), columns_ - (last_ % columns_));
+    assert(0 < length);
+
+    const Container::iterator destination = active_.begin() + last_;
+    active_size_ += std::count_if(destination, destination + length,
+        [](const rune::Rune & r) { return ! static_cast<bool>(r); });
+
+    std::copy(runes.begin(), runes.begin() + length, destination);
+    last_ += length - 1;
+    runes = runes.subspan(length);
+  }
+
+  assert(0 < active_size_);
+}
+
+/*
+ * last_ went past the end of its row, moves it to the beginning of the next
+ * one, unless it is the bottom of the scroll region which scrolls instead.
+ */
+void History::wrap() {
+  if (0 < bottom_) {
+    const uint32_t previous = (last_ - columns_) % active_.size();
+    const uint16_t line = 1 + (previous + active_.size() - first_) % active_.size() / columns_;
+    if (bottom_ == line) {
+      scroll(top_, bottom_, 1);
+      last_ = previous;
+      return;
+    } else if (active_.size() / columns_ == line) {
+      /* below the region nothing scrolls */
+      last_ = previous;
+      return;
+    }
+  }
+  last_ %= active_.size();
+  if (first_ == last_) {
+    scrollback();
+  }
+}
+
+/*
+ * moves the lines in between top and bottom n lines up, or down when n is
+ * negative, the lines leaving the region are dropped, not saved. scrolling
+ * the whole primary screen up moves the top lines into scrollback instead,
+ * as line feeds at its bottom would.
+ */
+void History::scroll(const uint16_t top, const uint16_t bottom, const int n) {
+  assert(0 < columns_);
+  assert(0 < top);
+  assert(top <= bottom);
+  assert(active_.size() / columns_ >= bottom);
+  assert(0 != n);
+  const uint16_t count = std::min<int>(std::abs(n), bottom - top + 1);
+
+  const auto drop = [this](const uint16_t line) {
+    const Container::const_iterator begin = active_.cbegin() + row(line);
+    active_size_ -= std::count_if(begin, begin + columns_,
+        [](const rune::Rune & r) { return static_cast<bool>(r); });
+  };
+
+  /* exposed lines are blank lines of their own, not wrapping into the next */
+  const auto clear = [this](const uint16_t line) {
+    const Container::iterator begin = active_.begin() + row(line);
+    std::fill(begin, begin + columns_, rune::Rune(L'\0'));
+    *begin = rune::Rune(L'\n');
+    ++active_size_;
+  };
+
+  const auto copy = [this](const uint16_t from, const uint16_t to) {
+    const Container::const_iterator begin = active_.cbegin() + row(from);
+    std::copy(begin, begin + columns_, active_.begin() + row(to));
+  };
+
+  if (0 < n && 1 == top && active_.size() / columns_ == bottom && is_scrollback_enabled()) {
+    for (uint16_t i = 0; count > i; ++i) {
+      scrollback();
+      /* the cursor stays on its line */
+      last_ = (last_ + columns_) % active_.size();
+      clear(bottom);
+    }
+  } else if (0 < n) {
+    for (uint16_t line = top; top + count > line; ++line) {
+      drop(line);
+    }
+    for (uint16_t line = top; bottom - count >= line; ++line) {
+      copy(line + count, line);
+    }
+    for (uint16_t line = bottom - count + 1; bottom >= line; ++line) {
+      clear(line);
+    }
+  } else {
+    for (uint16_t line = bottom - count + 1; bottom >= line; ++line) {
+      drop(line);
+    }
+    for (uint16_t line = bottom; top + count <= line; --line) {
+      copy(line - count, line);
+    }
+    for (uint16_t line = top; top + count > line; ++line) {
+      clear(line);
+    }
+  }
+}
+
+/*
+ * moves the top row into scrollback. rows without a new line were wrapped,
+ * the next one continues the same line there, however long it gets.
+ */
 void History::scrollback() {
   if (is_scrollback_disabled()) {
     first_ = (first_ + columns_) % active_.size();
@@ -70,45 +187,32 @@ void History::scrollback() {
   }
   assert(0 < columns_);
   assert(0 == first_ % columns_);
-  bool new_line = true;
-  uint32_t counter = 0;
-  do {
-    new_line = L'\n' == active_[first_];
-    if (new_line) {
+  const bool new_line = L'\n' == active_[first_];
+  if (new_line) {
 #if DEBUG_ACTIVE_SIZE
-      std::cout << __func__ << " " << __LINE__ << " --active_size_ = " << --active_size_ << std::endl;
+    std::cout << __func__ << " " << __LINE__ << " --active_size_ = " << --active_size_ << std::endl;
 #else
-      --active_size_;
+    --active_size_;
 #endif
-      active_[first_] = rune::Rune(L'\0');
-    }
-    for (uint32_t i = 1; i < columns_; ++i) {
-      rune::Rune & rune = active_[first_ + i];
-      if (static_cast<bool>(rune)) {
-        scrollback_.push_back(rune);
-        rune = rune::Rune(L'\0');
+    active_[first_] = rune::Rune(L'\0');
+  }
+  for (uint32_t i = 1; i < columns_; ++i) {
+    rune::Rune & rune = active_[first_ + i];
+    if (static_cast<bool>(rune)) {
+      scrollback_.push_back(rune);
+      rune = rune::Rune(L'\0');
 #if DEBUG_ACTIVE_SIZE
-        std::cout << __func__ << " " << __LINE__ << " --active_size_ = " << --active_size_ << std::endl;
+      std::cout << __func__ << " " << __LINE__ << " --active_size_ = " << --active_size_ << std::endl;
 #else
-        --active_size_;
+      --active_size_;
 #endif
-      }
-    }
-    first_ = (first_ + columns_) % active_.size();
-    ++counter;
-    if (active_.size() == counter) {
-      break;
     }
-  } while ( ! new_line);
-  scrollback_.push_back(rune::Rune(L'\n'));
-  ++scrollback_lines_;
-}
-
-History::ReverseIterator History::reverse_iterator(const uint64_t i) {
-  assert(scrollback_.size() >= i);
-  ReverseIterator iterator = scrollback_.rbegin();
-  iterator += scrollback_.size() - i;
-  return iterator;
+  }
+  first_ = (first_ + columns_) % active_.size();
+  if (new_line) {
+    scrollback_.push_back(rune::Rune(L'\n'));
+    ++scrollback_lines_;
+  }
 }
 
 void History::resize(uint16_t columns, const uint16_t lines) {
@@ -122,6 +226,8 @@ void History::resize(uint16_t columns, const uint16_t lines) {
   const uint64_t sizeBefore = size();
 #endif
   const uint32_t first = first_;
+  /* whatever region there was is reset by the screen */
+  top_ = bottom_ = 0;
   Container active(columns * lines);
   std::swap(active_, active);
   std::swap(columns_, columns);
@@ -152,51 +258,6 @@ void History::resize(uint16_t columns, const uint16_t lines) {
 #endif
 }
 
-uint64_t History::count_lines(History::ReverseIterator & iterator, const History::ReverseIterator & end, const uint64_t limit) const {
-  uint64_t lines = 0; // lines returns zero, only when iterator equals end from the start
-  History::ReverseIterator lineBegin = std::find(iterator, end, L'\n');
-  while (end != iterator && (0 == limit || limit >= lines)) {
-    ++lines;
-    uint32_t cursor_column = 1;
-    for (History::ReverseIterator line_iterator = lineBegin - 1;
-        iterator <= line_iterator; --line_iterator) {
-      uint32_t columns = 1;
-      if (line_iterator->iscontrol()) {
-        switch (line_iterator->character) {
-        case L'\n': // new line
-          continue;
-        case L'\t': // horizontal tab
-          columns = 8 - (cursor_column % 8);
-          break;
-        default:
-          std::cerr << static_cast<int>(line_iterator->character) << std::endl;
-          assert(!"UNIMPLEMENTED");
-          break;
-        }
-      }
-      const bool wrap = columns_ < cursor_column;
-      if (wrap) {
-        cursor_column = 1;
-        ++lines;
-        if (0 < limit && limit < lines) {
-          iterator = line_iterator;
-          return limit;
-        }
-      }
-      cursor_column += columns;
-    }
-    if (limit < lines) {
-      return limit;
-    }
-    iterator = lineBegin;
-    if (end != lineBegin) {
-      ++lineBegin;
-      lineBegin = std::find(lineBegin, end, L'\n');
-    }
-  }
-  return lines;
-}
-
 void History::print_active() const {
   std::cout << __FILE__ << ":" << __LINE__ << " " << __func__ << std::endl;
   uint32_t i = first_;
@@ -223,7 +284,7 @@ void History::print_active() const {
 
 void History::print_scrollback() const {
   std::cout << __FILE__ << ":" << __LINE__ << " " << __func__ << std::endl;
-  for (const auto & rune : scrollback_) {
+  for (const rune::Rune rune : scrollback_) {
     if (static_cast<bool>(rune)) {
       std::cout << rune << std::flush;
     }
@@ -251,118 +312,68 @@ void History::erase_display() {
   active_size_ = first_ = last_ = 0;
 }
 
-void History::erase_line_right() {
-  assert(0 < columns_);
-  uint32_t index = last_;
-  if (active_.size() <= index) {
-    index = 1;
-  } else if (0 == index % columns_) {
-    ++index;
-  }
-  for (; 0 != index % columns_; ++index) {
-    if (static_cast<bool>(active_[index])) {
-#if DEBUG_ACTIVE_SIZE
-      std::cout << __func__ << " " << __LINE__ << " --active_size_ = " << --active_size_ << std::endl;
-#else
-      --active_size_;
-#endif
-    }
-    active_[index] = rune::Rune('\0');
-  }
-}
-
-void History::erase(const int n) {
+uint32_t History::cursor() const {
   assert(0 < columns_);
-  assert(0 < n);
-  assert(0 < last_ % columns_);
-  assert(0 < last_ + n % columns_);
-  const uint32_t dst = last_,
-    end = last_ - (last_ % columns_) + columns_,
-    src = last_ + n;
-
-  // copies everything from index_ + n to end of line, back to index_,
-  // then fill remaining n characters with Rune()
-  std::fill(
-      std::copy(/* index_ + n */ active_.data() + src,
-        /* next line */ active_.data() + end,
-        /* index_ */ active_.data() + dst),
-      active_.data() + end, rune::Rune(L'\0'));
+  const uint32_t column = last_ % columns_;
+  return last_ - column + std::min<uint32_t>(column + 1, columns_ - 1);
 }
 
-void History::insert(const int n) {
-  assert(0 < columns_);
-  assert(0 < n);
-  assert(n <= columns_ - (last_ % columns_));
-  const uint32_t dst = last_ - (last_ % columns_) + columns_,
-    end = dst - n,
-    src = last_;
-  std::copy_backward(active_.data() + src, active_.data() + end, active_.data() + dst); 
-  for (uint32_t index = last_; last_ + n > index; ++index) {
-    if ( ! static_cast<bool>(active_[index].character)) {
-#if DEBUG_ACTIVE_SIZE
-      std::cout << __func__ << " " << __LINE__ << " ++active_size_ = " << ++active_size_ << std::endl;
-#else
-      ++active_size_;
-#endif
-    }
-    active_[index].character = L' ';
-  }
+void History::drop(const uint32_t index, const uint32_t count) {
+  assert(index / columns_ == (index + count - 1) / columns_);
+  const Container::const_iterator begin = active_.cbegin() + index;
+  active_size_ -= std::count_if(begin, begin + count,
+      [](const rune::Rune & r) { return static_cast<bool>(r); });
 }
 
-uint32_t History::check_size(const Container & c) const {
-  return std::count_if(c.begin(), c.end(),
-      [](const rune::Rune & r) { return static_cast<bool>(r); });
+void History::erase_line_right() {
+  const uint32_t index = cursor(),
+    end = index - (index % columns_) + columns_;
+  drop(index, end - index);
+  std::fill(active_.begin() + index, active_.begin() + end, rune::Rune(L'\0'));
 }
 
-void History::move_cursor_backward(const int n) {
+/*
+ * DCH, ICH and ECH, the rest of the row moves by n columns within the ring,
+ * whatever leaves the row is dropped.
+ */
+void History::erase(const int n) {
   assert(0 < n);
-  assert(n < columns_ - 1);
-  const uint32_t column = (last_ % columns_);
-  if (1 == column) {
-    return;
-  }
-  assert(n < column);
-  last_ -= n;
-  assert(0 <= last_);
-  assert(active_.size() > last_);
-  last_ %= active_.size();
-  if (0 == last_ % columns_) {
-    --last_;
-  }
+  const uint32_t index = cursor(),
+    end = index - (index % columns_) + columns_,
+    count = std::min<uint32_t>(n, end - index);
+  drop(index, count);
+  const Container::iterator begin = active_.begin() + index;
+  std::fill(std::copy(begin + count, active_.begin() + end, begin),
+      active_.begin() + end, rune::Rune(L'\0'));
 }
 
-void History::move_cursor_down(const int n) {
+void History::insert(const int n) {
   assert(0 < n);
-  assert(n <= active_.size() / columns_);
-  last_ += columns_ * n - 1;
-  last_ %= active_.size();
-  if (0 == last_ % columns_) {
-    --last_;
-  }
+  const uint32_t index = cursor(),
+    end = index - (index % columns_) + columns_,
+    count = std::min<uint32_t>(n, end - index);
+  drop(end - count, count);
+  const Container::iterator begin = active_.begin() + index;
+  std::copy_backward(begin, active_.begin() + end - count, active_.begin() + end);
+  /* blanks in the middle of a row are spaces, null would collapse them */
+  std::fill(begin, begin + count, rune::Rune(L' '));
+  active_size_ += count;
 }
 
-void History::move_cursor_forward(const int n) {
+void History::erase_characters(const int n) {
   assert(0 < n);
-  assert(n < columns_ - 1);
-  const uint32_t column = (last_ % columns_);
-  assert(n + column < columns_);
-  last_ += n;
-  assert(0 <= last_);
-  assert(active_.size() > last_);
-  last_ %= active_.size();
-  if (0 == last_ % columns_) {
-    --last_;
-  }
+  const uint32_t index = cursor(),
+    end = index - (index % columns_) + columns_,
+    count = std::min<uint32_t>(n, end - index);
+  drop(index, count);
+  const Container::iterator begin = active_.begin() + index;
+  std::fill(begin, begin + count, rune::Rune(L' '));
+  active_size_ += count;
 }
 
-void History::move_cursor_up(const int n) {
-  assert(0 < n);
-  assert(n <= active_.size() / columns_);
-  last_ -= columns_ * n - 1;
-  last_ %= active_.size();
-  if (0 == last_ % columns_) {
-    --last_;
-  }
+uint32_t History::check_size(const Container & c) const {
+  return std::count_if(c.begin(), c.end(),
+      [](const rune::Rune & r) { return static_cast<bool>(r); });
 }
 
 void History::move_cursor(const int column, const int line) {
@@ -370,11 +381,9 @@ void History::move_cursor(const int column, const int line) {
   assert(columns_ >= column);
   assert(0 < line);
   assert(active_.size() / columns_ >= line);
-  last_ = first_ + (line - 1) * columns_ + column - 0;
+  /* last_ is the last written, the row marker when at the first column */
+  last_ = first_ + (line - 1) * columns_ + column - 1;
   last_ %= active_.size();
-  if (0 == last_ % columns_) {
-    --last_;
-  }
 }
 
 void History::carriage_return() {
@@ -388,29 +397,59 @@ void History::carriage_return() {
 
 void History::new_line() {
   rune::Rune & rune = active_[last_ - (last_ % columns_)];
-  last_ = (last_ + columns_) % active_.size();
-  if (is_scrollback_enabled()) {
-    assert( ! static_cast<bool>(rune));
+  /* lines may be revisited, after scrolling or within a region */
+  if ( ! static_cast<bool>(rune)) {
 #if DEBUG_ACTIVE_SIZE
     std::cout << __func__ << " " << __LINE__ << " ++active_size_ = " << ++active_size_ << std::endl;
 #else
     ++active_size_;
 #endif
-  } else /* scrollback is disabled */ {
-    if ( ! static_cast<bool>(rune)) {
-#if DEBUG_ACTIVE_SIZE
-      std::cout << __func__ << " " << __LINE__ << " ++active_size_ = " << ++active_size_ << std::endl;
-#else
-    ++active_size_;
-#endif
-    }
   }
   rune = rune::Rune(L'\n');
+  if (0 < bottom_) {
+    const uint16_t line = get_cursor().second;
+    if (bottom_ == line) {
+      scroll(top_, bottom_, 1);
+      return;
+    } else if (active_.size() / columns_ == line) {
+      return;
+    }
+  }
+  last_ = (last_ + columns_) % active_.size();
   if (last_ >= first_ && last_ < first_ + columns_) {
     scrollback();
   }
 }
 
+/*
+ * fnv-1a over the active grid, row by row from the top of the screen,
+ * covering characters and their attributes.
+ */
+uint64_t History::checksum() const {
+  uint64_t hash = 0xcbf29ce484222325;
+  const auto combine = [&hash](const void * const data, const std::size_t size) {
+    const unsigned char * const bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; size > i; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+  };
+  for (std::size_t i = 0; active_.size() > i; ++i) {
+    const rune::Rune & rune = active_[(first_ + i) % active_.size()];
+    const rune::Attributes & a = rune.attributes();
+    const std::array<float, 8> colors{
+      a.background.red, a.background.green, a.background.blue, a.background.alpha,
+      a.foreground.red, a.foreground.green, a.foreground.blue, a.foreground.alpha,
+    };
+    const std::array<uint8_t, 4> attributes{
+      static_cast<uint8_t>(a.style), static_cast<uint8_t>(a.blink), a.crossout, a.underline,
+    };
+    combine(&rune.character, sizeof(rune.character));
+    combine(colors.data(), sizeof(colors));
+    combine(attributes.data(), sizeof(attributes));
+  }
+  return hash;
+}
+
 uint64_t History::size() const {
   return scrollback_size() + active_size_;
 }
@@ -428,122 +467,32 @@ std::pair<uint16_t, uint16_t> History::get_cursor() const {
   return cursor;
 }
 
+/*
+ * both grids stay allocated and switching swaps them, the alternative is
+ * cleared on the way in unless it is clean already. a resize in between
+ * reflows the primary once it is back.
+ */
 void History::alternative(const bool mode) {
-  if (mode) {
-    saved_ = Container(active_.size());
-    std::swap(saved_, active_);
-    saved_columns_ = columns_;
-    saved_first_ = first_;
-    saved_last_ = last_;
-    saved_size_ = active_size_;
-    active_size_ = first_ = last_ = 0;
-  } else {
-    std::swap(saved_, active_);
-    std::swap(columns_, saved_columns_);
-    assert(0 == saved_.size() % saved_columns_);
-#if 1
-    assert(columns_ == saved_columns_);
-#else
-    const int16_t lines = saved_.size() / saved_columns_;
-    if (active_.size() != saved_columns_ * lines) {
-      resize(saved_columns_ - 1, lines);
-    }
-#endif
-    first_ = saved_first_;
-    last_ = saved_last_;
-    active_size_ = saved_size_;
-    saved_.clear();
-    saved_columns_ = saved_first_ = saved_last_ = saved_size_ = 0;
+  if (mode == alternative_) {
+    return;
   }
-}
-
-void History::reverse_line_feed() {
-  assert(0 < columns_);
-  const bool pull_from_scrollback = (first_ == last_ - (last_ % columns_));
-
-  if (pull_from_scrollback) {
-    assert(0 == first_ % columns_);
-
-    if ( ! static_cast<bool>(active_[first_])) {
-#if DEBUG_ACTIVE_SIZE
-      std::cout << __func__ << " " << __LINE__ << " ++active_size_ = " << -++active_size_ << std::endl;
-#else
-      ++active_size_;
-#endif
-      active_[first_] = rune::Rune(L'\n');
-    }
-
-    // moves first_ one line up.
-    if (0 == first_) {
-      first_ = active_.size() - columns_;
-    } else {
-      first_ -= columns_;
-    }
-    assert(0 == first_ % columns_);
-
-    if ( ! static_cast<bool>(active_[first_])) {
-#if DEBUG_ACTIVE_SIZE
-      std::cout << __func__ << " " << __LINE__ << " ++active_size_ = " << -++active_size_ << std::endl;
-#else
-      ++active_size_;
-#endif
-      active_[first_] = rune::Rune(L'\n');
-    }
-
-    if ( ! scrollback_.empty()) {
-      assert(L'\n' == scrollback_.back());
-      scrollback_.pop_back();
-    }
-
-    Container::const_reverse_iterator back_iterator = scrollback_.crbegin();
-    for (uint16_t i = 1; columns_ > i && scrollback_.crend() != back_iterator; ++i, ++back_iterator) {
-      if (L'\n' == *back_iterator) {
-        break;
-      }
-    }
-    Container::const_reverse_iterator iterator = back_iterator;
-    if (scrollback_.crend() != iterator && L'\n' == *iterator) {
-      --iterator;
-    }
-    for (uint32_t index = 1; columns_ > index; ++index) {
-      const bool has_rune = static_cast<bool>(active_[first_ + index]);
-      if (scrollback_.crbegin() < iterator && scrollback_.crend() > iterator) {
-        active_[first_ + index] = *iterator;
-        --iterator;
-        if ( ! has_rune) {
-#if DEBUG_ACTIVE_SIZE
-          std::cout << __func__ << " " << __LINE__ << " ++active_size_ = " << ++active_size_ << std::endl;
-#else
-          ++active_size_;
-#endif
-        }
-      } else if (has_rune) {
-#if DEBUG_ACTIVE_SIZE
-        std::cout << __func__ << " " << __LINE__ << " --active_size_ = " << --active_size_ << std::endl;
-#else
-        --active_size_;
-#endif
-        active_[first_ + index] = rune::Rune(L'\0');
-      }
-    }
-    {
-      const std::size_t distance = std::distance(scrollback_.crbegin(), back_iterator);
-      assert(scrollback_.size() > distance);
-      for (uint16_t i = 0; distance > i; ++i) {
-        scrollback_.pop_back();
-      }
+  const uint16_t columns = columns_;
+  const uint32_t size = active_.size();
+  std::swap(active_, saved_);
+  std::swap(columns_, saved_columns_);
+  std::swap(first_, saved_first_);
+  std::swap(last_, saved_last_);
+  std::swap(active_size_, saved_size_);
+  alternative_ = mode;
+  if (mode) {
+    if (size != active_.size()) {
+      active_ = Container(size);
+    } else if (0 < active_size_) {
+      std::fill(active_.begin(), active_.end(), rune::Rune(L'\0'));
     }
+    columns_ = columns;
+    active_size_ = first_ = last_ = 0;
+  } else if (columns != columns_ || size != active_.size()) {
+    resize(columns - 1, size / columns);
   }
-
-  if ( ! scrollback_.empty() && L'\n' != scrollback_.back()) {
-    scrollback_.emplace_back(rune::Rune{L'\n'});
-  }
-
-  // moves last_ back one line + one positions
-  if (columns_ > last_) {
-    last_ = active_.size() - columns_ + (last_ % columns_);
-  } else {
-    last_ -= columns_;
-  }
-  --last_;
 }
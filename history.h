@@ -12,50 +12,60 @@
 #include <cstdint>
 
 #include "rune.h"
+#include "scrollback.h"
 
 class History {
   using Container = std::vector<rune::Rune>;
 
 public:
-  using Iterator = Container::const_iterator;
-  using ReverseIterator = Container::const_reverse_iterator;
+  using Iterator = Scrollback::Iterator;
+  using ReverseIterator = Scrollback::ReverseIterator;
 
   auto active_size() const -> uint32_t { return active_size_; }
   auto alternative(const bool) -> void;
   auto at(const uint32_t) const -> const rune::Rune &;
   auto at(const uint16_t, const uint16_t) const -> const rune::Rune &;
-  auto begin(const uint64_t) -> void { long_transaction_ = 1; }
   auto columns() const { return columns_; }
-  auto commit() -> void { long_transaction_ = 0; }
   auto erase_display() -> void;
   auto erase_scrollback() -> void { scrollback_.clear(); }
   auto carriage_return() -> void;
-  auto count_lines(ReverseIterator &, const ReverseIterator &, const uint64_t limit = 0) const -> uint64_t;
+  auto checksum() const -> uint64_t;
   auto emplace(rune::Rune) -> void;
+  auto emplace_run(std::span<const rune::Rune>) -> void;
   auto erase(const int) -> void;
+  auto erase_characters(const int) -> void;
   auto erase_line_right() -> void;
   auto insert(const int) -> void;
-  auto is_scrollback_disabled() const -> bool { return ! saved_.empty(); }
-  auto is_scrollback_enabled() const -> bool { return saved_.empty(); }
+  auto iterator(const uint64_t i) const -> Iterator { return scrollback_.begin() + i; }
+  /* of the scrollback rune at a byte offset of its text */
+  auto index(const uint64_t offset) const -> uint64_t { return scrollback_.index(offset); }
+  auto indexed() const -> const trigram::Stats & { return scrollback_.indexed(); }
+  auto is_alternative() const -> bool { return alternative_; }
+  auto is_scrollback_disabled() const -> bool { return alternative_; }
+  auto is_scrollback_enabled() const -> bool { return ! alternative_; }
   auto lines() const -> std::size_t { return scrollback_lines_; }
+  /* scrollback rows from the one holding index to the screen, and its column */
+  auto locate(const uint64_t index) const -> std::pair<uint64_t, uint16_t> { return scrollback_.locate(index, columns_ - 1); }
+  /* scroll region, 0, 0 for the whole screen */
+  auto margins(const uint16_t top, const uint16_t bottom) -> void { top_ = top; bottom_ = bottom; }
   auto new_line() -> void;
   auto print_active() const -> void;
   auto print_scrollback() const -> void;
   auto rbegin() const -> ReverseIterator { return scrollback_.rbegin(); }
   auto rend() const -> ReverseIterator { return scrollback_.rend(); }
   auto resize(const uint16_t, const uint16_t) -> void;
-  auto reverse_line_feed() -> void;
-  auto reverse_iterator(const uint64_t) -> ReverseIterator;
+  auto scroll(const uint16_t, const uint16_t, const int) -> void;
   auto scrollback_size() const -> uint64_t { return scrollback_.size(); }
   auto size() const -> uint64_t;
+  auto snapshot() const -> Scrollback::Snapshot { return scrollback_.snapshot(); }
+  auto spill(const spill::Options & o) -> void { scrollback_.spill(o); }
+  auto trigrams(const std::size_t b) -> void { scrollback_.trigrams(b); }
+  /* scrollback rows before index, laid out at the width of the screen */
+  auto rewind(const uint64_t index, const uint64_t n) const -> std::pair<uint64_t, uint64_t> { return scrollback_.rewind(index, n, columns_ - 1); }
 
   // cursor, manipulates the last_ position.
   auto get_cursor() const -> std::pair<uint16_t, uint16_t>;
   auto move_cursor(const int, const int) -> void;
-  auto move_cursor_backward(const int) -> void;
-  auto move_cursor_down(const int) -> void;
-  auto move_cursor_forward(const int) -> void;
-  auto move_cursor_up(const int) -> void;
 
 private:
   /*
@@ -72,9 +82,17 @@ private:
 
   auto check_size(const Container &) const -> uint32_t;
 
+  /* index under the cursor, the last column while a wrap is pending */
+  auto cursor() const -> uint32_t;
+  /* blanks count runes from index, not crossing the end of its row */
+  auto drop(const uint32_t, const uint32_t) -> void;
+
+  /* index where a line of the screen starts */
+  auto row(const uint16_t line) const -> uint32_t { return (first_ + (line - 1) * columns_) % active_.size(); }
   auto scrollback() -> void;
+  auto wrap() -> void;
 
-  Container scrollback_; // scrollback buffer
+  Scrollback scrollback_; // scrollback buffer
   uint64_t scrollback_lines_ = 0;
 
   Container active_; // circular buffer representing the screen
@@ -83,12 +101,15 @@ private:
   uint32_t first_ = 0;
   uint32_t last_ = 0;
 
-  // alternative container
+  // scroll region, lines 1 based
+  uint16_t top_ = 0;
+  uint16_t bottom_ = 0;
+
+  // the other screen, primary or alternative, kept allocated
+  bool alternative_ = false;
   Container saved_;
   uint16_t saved_columns_ = 0;
   uint32_t saved_first_ = 0;
   uint32_t saved_last_ = 0;
   uint32_t saved_size_ = 0;
-
-  uint64_t long_transaction_ = 0;
 };
@@ -7,8 +7,24 @@
 
 #include "keyboard.h"
 
+namespace {
+
+constexpr uint32_t SHIFT = 0x1;
+constexpr uint32_t CONTROL = 0x4;
+
+} // end of annonymous namespace
+
 void Keyboard::on_key_press(const uint32_t key, const char * const utf8, const size_t bytes, const uint32_t modifiers) {
-    
+  if ((CONTROL | SHIFT) == (modifiers & (CONTROL | SHIFT)) && (XKB_KEY_F == key || XKB_KEY_f == key)) {
+    pattern_.clear();
+    screen_.search(pattern_, regex_);
+    return;
+  }
+  if (screen_.searching()) {
+    search(key, utf8, bytes, modifiers);
+    return;
+  }
+
 #if 0
   // example as how to certain key sequences should be handled outside the shell.
   if (0 != (modifiers & 0x4 /* crtl key */)) {
@@ -47,3 +63,44 @@ void Keyboard::on_key_press(const uint32_t key, const char * const utf8, const s
   terminal_.write(utf8, bytes);
 }
 
+
+/*
+ * typing refines the pattern, return goes to the next older match and shift
+ * return to the newer one, control r toggles regular expressions and escape
+ * ends the search.
+ */
+void Keyboard::search(const uint32_t key, const char * const utf8, const size_t bytes, const uint32_t modifiers) {
+  switch (key) {
+  case XKB_KEY_Escape:
+    screen_.stop_search();
+    return;
+  case XKB_KEY_Return:
+  case XKB_KEY_KP_Enter:
+    screen_.search_next(0 == (modifiers & SHIFT));
+    return;
+  case XKB_KEY_BackSpace:
+    /* a whole character */
+    while ( ! pattern_.empty() && 0x80 == (pattern_.back() & 0xc0)) {
+      pattern_.pop_back();
+    }
+    if ( ! pattern_.empty()) {
+      pattern_.pop_back();
+    }
+    screen_.search(pattern_, regex_);
+    return;
+  }
+
+  if (0 != (modifiers & CONTROL)) {
+    if (XKB_KEY_r == key || XKB_KEY_R == key) {
+      regex_ = ! regex_;
+      screen_.search(pattern_, regex_);
+    }
+    return;
+  }
+
+  const unsigned char c = 0 < bytes ? utf8[0] : 0;
+  if (0x20 <= c && 0x7f != c) {
+    pattern_.append(utf8, bytes);
+    screen_.search(pattern_, regex_);
+  }
+}
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "screen.h"
 #include "terminal.h"
 
@@ -9,6 +11,11 @@ struct Keyboard {
   Keyboard(Screen & screen, Terminal & terminal): screen_(screen), terminal_(terminal) { }
   auto on_key_press(const uint32_t, const char * const, const size_t, const uint32_t) -> void;
 private:
+  /* while searching keys edit the pattern rather than going to the shell */
+  auto search(const uint32_t, const char * const, const size_t, const uint32_t) -> void;
+
   Screen & screen_;
   Terminal & terminal_;
+  std::string pattern_;
+  bool regex_ = false;
 };
@@ -0,0 +1,123 @@
+// Copyright Daniel Morilha 2025
+
+#include <array>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "lz.h"
+
+namespace lz {
+
+namespace {
+constexpr std::size_t MINIMUM = 4;
+constexpr std::size_t WINDOW = 0xffff;
+constexpr uint32_t HASH_BITS = 12;
+
+uint32_t read32(const char * const p) {
+  uint32_t v = 0;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t hash(const uint32_t v) {
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/* lengths of 15 and over continue in bytes of 255 */
+void length(std::string & output, std::size_t n) {
+  for (; 255 <= n; n -= 255) {
+    output.push_back(static_cast<char>(255));
+  }
+  output.push_back(static_cast<char>(n));
+}
+
+std::size_t length(const unsigned char * & input, std::size_t n) {
+  if (15 == n) {
+    unsigned char byte = 0;
+    do {
+      byte = *input++;
+      n += byte;
+    } while (255 == byte);
+  }
+  return n;
+}
+
+void sequence(std::string & output, const std::string_view literals, const std::size_t offset, const std::size_t match) {
+  const std::size_t extra = 0 < match ? match - MINIMUM : 0;
+  output.push_back(static_cast<char>((std::min<std::size_t>(literals.size(), 15) << 4)
+        | std::min<std::size_t>(extra, 15)));
+  if (15 <= literals.size()) {
+    length(output, literals.size() - 15);
+  }
+  output.append(literals);
+  if (0 < match) {
+    output.push_back(static_cast<char>(offset & 0xff));
+    output.push_back(static_cast<char>(offset >> 8));
+    if (15 <= extra) {
+      length(output, extra - 15);
+    }
+  }
+}
+} // end of annonymous namespace
+
+std::string compress(const std::string_view input) {
+  std::string output;
+  output.reserve(input.size() / 2);
+  std::array<int64_t, 1 << HASH_BITS> table;
+  table.fill(-1);
+
+  std::size_t anchor = 0, i = 0;
+  while (input.size() >= i + MINIMUM) {
+    const uint32_t v = read32(input.data() + i);
+    const uint32_t h = hash(v);
+    const int64_t candidate = table[h];
+    table[h] = i;
+    if (0 <= candidate && WINDOW >= i - candidate && read32(input.data() + candidate) == v) {
+      std::size_t match = MINIMUM;
+      while (input.size() > i + match && input[candidate + match] == input[i + match]) {
+        ++match;
+      }
+      sequence(output, input.substr(anchor, i - anchor), i - candidate, match);
+      i += match;
+      anchor = i;
+    } else {
+      ++i;
+    }
+  }
+  /* the last sequence has literals only */
+  sequence(output, input.substr(anchor), 0, 0);
+  return output;
+}
+
+std::string decompress(const std::string_view input, const std::size_t size) {
+  std::string output(size, '\0');
+  const unsigned char * iterator = reinterpret_cast<const unsigned char *>(input.data());
+  const unsigned char * const END = iterator + input.size();
+  std::size_t position = 0;
+  while (END > iterator) {
+    const unsigned char token = *iterator++;
+    const std::size_t literals = length(iterator, token >> 4);
+    assert(size >= position + literals);
+    memcpy(output.data() + position, iterator, literals);
+    iterator += literals;
+    position += literals;
+    if (END == iterator) {
+      break;
+    }
+    const std::size_t offset = iterator[0] | (iterator[1] << 8);
+    iterator += 2;
+    const std::size_t match = length(iterator, token & 0x0f) + MINIMUM;
+    assert(0 < offset && position >= offset);
+    assert(size >= position + match);
+    /* matches may overlap what they copy, byte by byte */
+    for (std::size_t i = 0; match > i; ++i, ++position) {
+      output[position] = output[position - offset];
+    }
+  }
+  assert(size == position);
+  return output;
+}
+
+} // end of namespace lz
@@ -0,0 +1,24 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <cstddef>
+
+/*
+ * a small lz77 codec in the spirit of lz4, for sealed blocks of scrollback.
+ *
+ * sequences of literals are followed by a match, 4 bytes or longer, found
+ * through a hash of the next 4 bytes and referenced by a 16 bits offset, so
+ * blocks up to 64 KiB see all of themselves. repeated lines, prompts and
+ * indentation collapse into matches, there is no entropy coding.
+ */
+namespace lz {
+
+auto compress(const std::string_view) -> std::string;
+/* size is the one of the input given to compress */
+auto decompress(const std::string_view, const std::size_t) -> std::string;
+
+} // end of namespace lz
@@ -1,11 +1,20 @@
 // Copyright Daniel Morilha 2025
 
 #include <chrono>
+#include <iostream>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <cstdlib>
+
+#include <sys/socket.h>
 
 #include "freetype.h"
 #include "keyboard.h"
 #include "poller.h"
+#include "recording.h"
 #include "screen.h"
 #include "terminal.h"
 #include "wayland.h"
@@ -14,7 +23,7 @@ using namespace std::chrono_literals;
 
 template<class PAINT>
 struct WaylandPoller : public Events {
-  WaylandPoller(wayland::Connection & c, PAINT && p) : Events(16ms), connection_(c), paint(p) { }
+  WaylandPoller(wayland::Connection & c, PAINT && p) : Events(16ms, true), connection_(c), paint(p) { }
   void timeout() override;
 private:
   constexpr auto millis() -> uint16_t {
@@ -36,28 +45,142 @@ void WaylandPoller<PAINT>::timeout() {
   connection_.roundtrip();
 }
 
+/* periodically prints the poller's frame budget, how the child is read and jump scrolling */
+struct Statistics : public Events {
+  Statistics(const Poller & p, const Terminal & t, const Screen & s) : Events(1000ms), poller_(p), terminal_(t), screen_(s) { }
+  void timeout() override;
+private:
+  const Poller & poller_;
+  const Terminal & terminal_;
+  const Screen & screen_;
+  ReadBuffer::Stats reads_;
+};
+
+void Statistics::timeout() {
+  const ReadBuffer::Stats reads = terminal_.reads();
+  std::cerr << poller_.budget().stats() << std::endl
+    << reads << ", " << (reads.reads - reads_.reads) << " reads/s" << std::endl
+    << screen_.jumps() << std::endl
+    << screen_.indexed() << std::endl
+    << rune::AttributesTable::size() << " attributes interned" << std::endl;
+  reads_ = reads;
+}
+
 int main(int argc, char ** argv) {
   setlocale(LC_CTYPE, "en_US.UTF-8");
 
+  Terminal::Options options;
+  Screen::JumpScroll jump_scroll;
+  std::optional<spill::Options> spill;
+  std::size_t index = 0;
+  bool statistics = false;
+  std::string replay;
+  /* replays as fast as possible unless given a speed */
+  double speed = 0;
+  for (int i = 1; argc > i; ++i) {
+    const std::string_view argument{argv[i]};
+    const bool has_value = argc > i + 1;
+    if ("--threaded" == argument) {
+      /* reads and parses the child's output on a separate thread */
+      options.threaded = true;
+    } else if ("--stats" == argument) {
+      statistics = true;
+    } else if ("--record" == argument && has_value) {
+      options.record = argv[++i];
+    } else if ("--buffer" == argument && has_value) {
+      /* the most bytes a single read may return */
+      options.buffer = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--backlog" == argument && has_value) {
+      /* bytes read in between renders before the child is throttled, 0 never throttles */
+      options.backlog = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--jump-scroll" == argument && has_value) {
+      /* screens scrolled within a frame before only the last one is drawn, 0 disables it */
+      jump_scroll.screens = std::atoi(argv[++i]);
+    } else if ("--spill" == argument && has_value) {
+      /* bytes of scrollback kept in memory before older blocks spill to disk */
+      spill.emplace().memory = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--spill-quota" == argument && has_value && spill.has_value()) {
+      /* bytes of scrollback on disk before the oldest expires, 0 keeps everything */
+      spill->disk = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--spill-directory" == argument && has_value && spill.has_value()) {
+      /* where the unlinked file goes rather than a memfd */
+      spill->directory = argv[++i];
+    } else if ("--index" == argument && has_value) {
+      /* bytes of trigram filters speeding up searches through scrollback */
+      index = std::strtoul(argv[++i], nullptr, 10);
+    } else if ("--replay" == argument && has_value) {
+      replay = argv[++i];
+    } else if ("--speed" == argument && has_value) {
+      const std::string_view value{argv[++i]};
+      speed = "max" == value ? 0 : std::atof(argv[i]);
+    } else {
+      std::cerr << "usage: " << argv[0]
+        << " [--threaded] [--stats] [--buffer bytes] [--backlog bytes] [--jump-scroll screens] [--spill bytes [--spill-quota bytes] [--spill-directory path]] [--index bytes] [--record file] [--replay file [--speed max|factor]]" << std::endl;
+      return 1;
+    }
+  }
+
   wayland::Connection connection;
   connection.connect();
   connection.capabilities();
 
   Screen screen{Screen::New(connection)};
+  screen.jump_scroll(jump_scroll);
+  if (spill.has_value()) {
+    screen.spill(*spill);
+  }
+  if (0 < index) {
+    screen.trigrams(index);
+  }
 
   connection.roundtrip();
 
   Poller poller(/* timeout for ~60 fps */ 16ms);
 
-  auto t = Terminal::New(screen);
-  const int fd = t->childfd();
+  /* replaying, the recording is written into a socket in place of the pty */
+  std::optional<recording::Player> player;
+  std::optional<recording::Report> report;
+  std::unique_ptr<Terminal> t;
+  if (replay.empty()) {
+    t = Terminal::New(screen, options);
+  } else {
+    int sockets[2] = {-1, -1};
+    if (0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets)) {
+      std::cerr << "failed to create socket pair" << std::endl;
+      return 1;
+    }
+    report.emplace();
+    t = Terminal::Replay(screen, sockets[0], options);
+    player.emplace(replay, speed, sockets[1]);
+  }
+  const int fd = t->pollfd();
 
   Terminal & terminal = poller.add(fd, std::move(t));
 
+  if (report.has_value()) {
+    terminal.onHangup = [&]() {
+      if (poller.is_running()) {
+        report->bytes = player->bytes();
+        report->checksum = screen.checksum();
+        std::cout << report.value() << std::endl;
+        poller.off();
+      }
+    };
+  }
+
   poller.add(connection.fd(), std::unique_ptr<Events>(new WaylandPoller(connection, [&](const bool force, const bool alt) {
+    const uint64_t frames = screen.frames();
+    const auto start = std::chrono::steady_clock::now();
     screen.repaint(force, alt);
+    if (report.has_value() && frames != screen.frames()) {
+      report->frame(std::chrono::steady_clock::now() - start);
+    }
   })));
 
+  if (statistics) {
+    poller.add(-1, std::make_unique<Statistics>(poller, terminal, screen));
+  }
+
   {
     Keyboard keyboard(screen, terminal);
     connection.onKeyPress = std::bind_front(&Keyboard::on_key_press, keyboard);
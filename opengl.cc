@@ -213,6 +213,17 @@ Framebuffer Framebuffer::clone(const GLsizei width, const GLsizei height) const
   return result;
 }
 
+void Framebuffer::copy(const Framebuffer & source, const Rectangle & rectangle, const GLint x, const GLint y) const {
+  assert(0 != source.framebuffer_);
+  assert(0 != texture_);
+  assert( ! (source == *this));
+  glBindFramebuffer(GL_FRAMEBUFFER, source.framebuffer_);
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, x, y, rectangle.x, rectangle.y, rectangle.width, rectangle.height);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 void Framebuffer::bind() const {
   assert(0 != framebuffer_);
   assert(0 != texture_);
@@ -105,6 +105,8 @@ struct Framebuffer {
 
   auto bind() const -> void;
   auto clone(const GLsizei, const GLsizei) const -> Framebuffer;
+  /* copies a rectangle of another framebuffer into x, y, from the bottom left */
+  auto copy(const Framebuffer &, const Rectangle &, const GLint, const GLint) const -> void;
   auto draw() const -> Draw;
   auto read() const -> Read;
   auto operator == (const Framebuffer & o) const -> bool { return framebuffer_ == o.framebuffer_; }
@@ -0,0 +1,106 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <list>
+#include <set>
+
+#include <cassert>
+
+#include "opengl.h"
+#include "types.h"
+
+struct Damage {
+  // expensive
+  using Container = std::set<Rectangle>;
+  auto area() const -> uint32_t;
+  auto clear() -> void { container_.clear(); }
+  auto emplace(Rectangle &&) -> void;
+  auto empty() const -> bool { return container_.empty(); }
+
+  template <typename Container>
+  void transfer(Container & c) {
+    while ( ! container_.empty()) {
+      c.emplace(c.cend(), container_.extract(container_.begin()).value());
+    }
+  }
+
+  Container container_;
+};
+
+struct Pages {
+private:
+  struct Entry {
+    opengl::Framebuffer framebuffer;
+    opengl::Framebuffer alternative;
+    Rectangle_Y area;
+    uint64_t index = 0;
+    /* drawn from scrollback, above the pages drawn live */
+    bool scrollback = false;
+  };
+
+  using Container = std::list<Entry>;
+
+public:
+  struct Drawer {
+    ~Drawer();
+    auto alternative() const -> bool; 
+    auto clear(const Color & color) const -> void;
+    auto create_alternative() const -> void;
+    const Rectangle target;
+  private:
+    Drawer(const Pages &, Entry &, Rectangle &&);
+    Entry & entry_;
+    const Pages & pages_;
+    friend class Pages;
+  };
+
+  Pages(const uint8_t cap = 0) : cap_(cap) { assert( 1 < cap_); }
+
+  /* clears a rectangle, along with its alternative */
+  auto blank(const Rectangle_Y &, const uint64_t) -> Rectangle;
+  /* an empty canvas, reusing the first page when the size did not change */
+  auto clear(const uint16_t, const uint16_t) -> void;
+  auto draw(Rectangle_Y, const uint64_t) -> Drawer;
+  /* forgets the pages drawn from scrollback, all or those outside [top, bottom) */
+  auto drop_scrollback() -> void;
+  auto drop_scrollback(const int64_t, const int64_t) -> void;
+  auto emplace_front(const int32_t) -> Entry &;
+  /* a page whose bottom is at y */
+  auto emplace_front(const int32_t, const int64_t) -> Entry &;
+  auto front_index() const -> uint64_t { return container_.empty() ? 0 : container_.front().index; }
+  auto front_y() const -> int64_t { return container_.empty() ? 0 : container_.front().area.y; }
+  auto has_alternative() const -> bool;
+  /* of the first page drawn live, and of the bottom of the pages drawn from scrollback */
+  auto live_y() const -> int64_t;
+  auto scrollback_y() const -> int64_t;
+  auto is_current(Entry & entry) const -> bool { return current_->framebuffer == entry.framebuffer; }
+  auto move(const Rectangle_Y &, const int32_t, const int64_t) -> void;
+  auto paint(const uint16_t frame = 0) -> bool;
+  auto repaint(const Rectangle, const int64_t, const bool alternative = false) -> void;
+  auto reset(const uint16_t, const uint16_t) -> void;
+  /* exchanges canvases with other, in constant time */
+  auto swap(Pages &) -> void;
+  auto total_height() const -> uint32_t;
+
+  constexpr auto height() const { return height_; }
+  constexpr auto scale_height() const { return 2.f / height_; }
+  constexpr auto scale_width() const { return 2.f / width_; }
+
+private:
+  auto new_entry(const Rectangle_Y &, const uint64_t) -> Entry;
+  auto update(Rectangle_Y &, const uint64_t) -> Entry &;
+
+  Container container_;
+  Container::iterator current_ = container_.end();
+
+  opengl::Shader glProgram_;
+  /* staging for moves, which may overlap or span two pages */
+  opengl::Framebuffer scratch_;
+
+  uint16_t height_ = 0;
+  uint16_t width_ = 0;
+  uint8_t cap_ = 0;
+
+  friend class Screen;
+};
@@ -0,0 +1,25 @@
+// Copyright Daniel Morilha 2025
+
+#include "parser.h"
+
+namespace parser {
+
+std::ostream & operator << (std::ostream & o, const Parameters & p) {
+  for (std::size_t i = 0; p.size() > i; ++i) {
+    if (0 < i) {
+      o << (p.is_subparameter(i) ? ':' : ';');
+    }
+    o << p[i];
+  }
+  return o;
+}
+
+std::ostream & operator << (std::ostream & o, const Sequence & s) {
+  if ('\0' != s.marker) {
+    o << s.marker;
+  }
+  o << s.parameters << s.intermediates();
+  return o;
+}
+
+} // end of namespace parser
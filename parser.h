@@ -0,0 +1,410 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <array>
+#include <ostream>
+#include <string_view>
+
+#include <cstdint>
+
+/*
+ * DEC ANSI compatible parser, following the state machine described by
+ * Paul Williams at https://vt100.net/emu/dec_ansi_parser
+ *
+ * The transition table is generated at compile time and indexed by the current
+ * state and the raw input byte. Every entry carries the exit action of the
+ * current state, the transition action and the entry action of the next state,
+ * so dispatching a byte is a single table look-up.
+ *
+ * C1 controls (0x80 - 0x9f) are not recognized, these bytes are utf-8
+ * continuation bytes and are printed (ground) or collected as string data
+ * (osc) instead.
+ */
+namespace parser {
+
+enum class State : uint8_t {
+  GROUND,
+  ESCAPE,
+  ESCAPE_INTERMEDIATE,
+  CSI_ENTRY,
+  CSI_PARAM,
+  CSI_INTERMEDIATE,
+  CSI_IGNORE,
+  DCS_ENTRY,
+  DCS_PARAM,
+  DCS_INTERMEDIATE,
+  DCS_PASSTHROUGH,
+  DCS_IGNORE,
+  OSC_STRING,
+  SOS_PM_APC_STRING,
+
+  UPPER_BOUND,
+};
+
+enum class Action : uint8_t {
+  NONE,
+  CLEAR,
+  COLLECT,
+  CSI_DISPATCH,
+  ESC_DISPATCH,
+  EXECUTE,
+  HOOK,
+  IGNORE,
+  OSC_END,
+  OSC_PUT,
+  OSC_START,
+  PARAM,
+  PRINT,
+  PUT,
+  UNHOOK,
+};
+
+struct Transition {
+  Action exit = Action::NONE;
+  Action action = Action::NONE;
+  Action entry = Action::NONE;
+  State state = State::GROUND;
+};
+
+constexpr std::size_t STATES = static_cast<std::size_t>(State::UPPER_BOUND);
+
+using Table = std::array<std::array<Transition, 256>, STATES>;
+
+namespace detail {
+
+constexpr Action on_entry(const State state) {
+  switch (state) {
+  case State::CSI_ENTRY:
+  case State::DCS_ENTRY:
+  case State::ESCAPE:
+    return Action::CLEAR;
+  case State::DCS_PASSTHROUGH:
+    return Action::HOOK;
+  case State::OSC_STRING:
+    return Action::OSC_START;
+  default:
+    return Action::NONE;
+  }
+}
+
+constexpr Action on_exit(const State state) {
+  switch (state) {
+  case State::DCS_PASSTHROUGH:
+    return Action::UNHOOK;
+  case State::OSC_STRING:
+    return Action::OSC_END;
+  default:
+    return Action::NONE;
+  }
+}
+
+struct Builder {
+  Table table{};
+  State state = State::GROUND;
+
+  // an action which keeps the current state.
+  constexpr void event(const uint8_t first, const uint8_t last, const Action action) {
+    for (int c = first; last >= c; ++c) {
+      table[static_cast<std::size_t>(state)][c] = Transition{
+        .exit = Action::NONE,
+        .action = action,
+        .entry = Action::NONE,
+        .state = state,
+      };
+    }
+  }
+
+  constexpr void event(const uint8_t c, const Action action) { event(c, c, action); }
+
+  // moves to the target state, running exit and entry actions.
+  constexpr void transition(const uint8_t first, const uint8_t last, const Action action, const State target) {
+    for (int c = first; last >= c; ++c) {
+      table[static_cast<std::size_t>(state)][c] = Transition{
+        .exit = on_exit(state),
+        .action = action,
+        .entry = on_entry(target),
+        .state = target,
+      };
+    }
+  }
+
+  constexpr void transition(const uint8_t c, const Action action, const State target) {
+    transition(c, c, action, target);
+  }
+
+  // c0 controls, except for the ones handled by anywhere().
+  constexpr void c0(const Action action) {
+    event(0x00, 0x17, action);
+    event(0x19, action);
+    event(0x1c, 0x1f, action);
+  }
+
+  constexpr void anywhere() {
+    transition(0x18, Action::EXECUTE, State::GROUND);
+    transition(0x1a, Action::EXECUTE, State::GROUND);
+    transition(0x1b, Action::NONE, State::ESCAPE);
+  }
+};
+
+constexpr Table make_table() {
+  Builder b;
+
+  b.state = State::GROUND;
+  b.c0(Action::EXECUTE);
+  b.event(0x20, 0x7e, Action::PRINT);
+  b.event(0x7f, Action::IGNORE);
+  b.event(0x80, 0xff, Action::PRINT);
+  b.anywhere();
+
+  b.state = State::ESCAPE;
+  b.c0(Action::EXECUTE);
+  b.event(0x7f, Action::IGNORE);
+  b.event(0x80, 0xff, Action::IGNORE);
+  b.transition(0x20, 0x2f, Action::COLLECT, State::ESCAPE_INTERMEDIATE);
+  b.transition(0x30, 0x7e, Action::ESC_DISPATCH, State::GROUND);
+  b.transition('P', Action::NONE, State::DCS_ENTRY);
+  b.transition('X', Action::NONE, State::SOS_PM_APC_STRING);
+  b.transition('[', Action::NONE, State::CSI_ENTRY);
+  b.transition(']', Action::NONE, State::OSC_STRING);
+  b.transition('^', Action::NONE, State::SOS_PM_APC_STRING);
+  b.transition('_', Action::NONE, State::SOS_PM_APC_STRING);
+  b.anywhere();
+
+  b.state = State::ESCAPE_INTERMEDIATE;
+  b.c0(Action::EXECUTE);
+  b.event(0x20, 0x2f, Action::COLLECT);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x30, 0x7e, Action::ESC_DISPATCH, State::GROUND);
+  b.anywhere();
+
+  b.state = State::CSI_ENTRY;
+  b.c0(Action::EXECUTE);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x20, 0x2f, Action::COLLECT, State::CSI_INTERMEDIATE);
+  b.transition(0x30, 0x3b, Action::PARAM, State::CSI_PARAM);
+  b.transition(0x3c, 0x3f, Action::COLLECT, State::CSI_PARAM);
+  b.transition(0x40, 0x7e, Action::CSI_DISPATCH, State::GROUND);
+  b.anywhere();
+
+  b.state = State::CSI_PARAM;
+  b.c0(Action::EXECUTE);
+  b.event(0x30, 0x3b, Action::PARAM);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x20, 0x2f, Action::COLLECT, State::CSI_INTERMEDIATE);
+  b.transition(0x3c, 0x3f, Action::NONE, State::CSI_IGNORE);
+  b.transition(0x40, 0x7e, Action::CSI_DISPATCH, State::GROUND);
+  b.anywhere();
+
+  b.state = State::CSI_INTERMEDIATE;
+  b.c0(Action::EXECUTE);
+  b.event(0x20, 0x2f, Action::COLLECT);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x30, 0x3f, Action::NONE, State::CSI_IGNORE);
+  b.transition(0x40, 0x7e, Action::CSI_DISPATCH, State::GROUND);
+  b.anywhere();
+
+  b.state = State::CSI_IGNORE;
+  b.c0(Action::EXECUTE);
+  b.event(0x20, 0x3f, Action::IGNORE);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x40, 0x7e, Action::NONE, State::GROUND);
+  b.anywhere();
+
+  b.state = State::DCS_ENTRY;
+  b.c0(Action::IGNORE);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x20, 0x2f, Action::COLLECT, State::DCS_INTERMEDIATE);
+  b.transition(0x30, 0x3b, Action::PARAM, State::DCS_PARAM);
+  b.transition(0x3c, 0x3f, Action::COLLECT, State::DCS_PARAM);
+  b.transition(0x40, 0x7e, Action::NONE, State::DCS_PASSTHROUGH);
+  b.anywhere();
+
+  b.state = State::DCS_PARAM;
+  b.c0(Action::IGNORE);
+  b.event(0x30, 0x3b, Action::PARAM);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x20, 0x2f, Action::COLLECT, State::DCS_INTERMEDIATE);
+  b.transition(0x3c, 0x3f, Action::NONE, State::DCS_IGNORE);
+  b.transition(0x40, 0x7e, Action::NONE, State::DCS_PASSTHROUGH);
+  b.anywhere();
+
+  b.state = State::DCS_INTERMEDIATE;
+  b.c0(Action::IGNORE);
+  b.event(0x20, 0x2f, Action::COLLECT);
+  b.event(0x7f, 0xff, Action::IGNORE);
+  b.transition(0x30, 0x3f, Action::NONE, State::DCS_IGNORE);
+  b.transition(0x40, 0x7e, Action::NONE, State::DCS_PASSTHROUGH);
+  b.anywhere();
+
+  b.state = State::DCS_PASSTHROUGH;
+  b.c0(Action::PUT);
+  b.event(0x20, 0x7e, Action::PUT);
+  b.event(0x7f, Action::IGNORE);
+  b.event(0x80, 0xff, Action::PUT);
+  b.anywhere();
+
+  b.state = State::DCS_IGNORE;
+  b.c0(Action::IGNORE);
+  b.event(0x20, 0xff, Action::IGNORE);
+  b.anywhere();
+
+  b.state = State::OSC_STRING;
+  b.c0(Action::IGNORE);
+  b.event(0x20, 0x7e, Action::OSC_PUT);
+  b.event(0x7f, Action::IGNORE);
+  b.event(0x80, 0xff, Action::OSC_PUT);
+  // xterm accepts bell as the string terminator.
+  b.transition('\a', Action::NONE, State::GROUND);
+  b.anywhere();
+
+  b.state = State::SOS_PM_APC_STRING;
+  b.c0(Action::IGNORE);
+  b.event(0x20, 0xff, Action::IGNORE);
+  b.anywhere();
+
+  return b.table;
+}
+
+} // end of namespace detail
+
+/*
+ * CSI and DCS parameters, filled one byte at a time by the PARAM action.
+ * Parameters are separated by ';' and sub parameters by ':', values
+ * saturate at 65535 and anything beyond CAPACITY is dropped, missing values
+ * are stored as 0, which means default for nearly every control function.
+ */
+struct Parameters {
+  constexpr static std::size_t CAPACITY = 32;
+
+  constexpr auto add(const char c) -> void {
+    if (0 == size_) {
+      values_[size_++] = 0;
+    }
+    if ('0' <= c && '9' >= c) {
+      uint32_t & value = values_[size_ - 1];
+      value = value * 10 + (c - '0');
+      if (MAXIMUM < value) {
+        value = MAXIMUM;
+      }
+    } else if (';' == c || ':' == c) {
+      if (CAPACITY > size_) {
+        const uint32_t bit = 1u << size_;
+        subparameters_ = ':' == c ? subparameters_ | bit : subparameters_ & ~bit;
+        values_[size_++] = 0;
+      } else {
+        // overflow, keeps overwriting the last parameter.
+        values_[size_ - 1] = 0;
+      }
+    }
+  }
+
+  constexpr auto clear() -> void { size_ = 0; subparameters_ = 0; }
+  constexpr auto empty() const -> bool { return 0 == size_; }
+  constexpr auto size() const -> std::size_t { return size_; }
+
+  // the value at index, or fallback when it is either missing or zero.
+  constexpr auto get(const std::size_t index, const uint32_t fallback = 0) const -> uint32_t {
+    return size_ > index && 0 < values_[index] ? values_[index] : fallback;
+  }
+
+  // whether the parameter at index was separated from the previous one by ':'.
+  constexpr auto is_subparameter(const std::size_t index) const -> bool {
+    return size_ > index && 0 != (subparameters_ & (1u << index));
+  }
+
+  constexpr auto operator [] (const std::size_t index) const -> uint32_t { return get(index); }
+
+  friend std::ostream & operator << (std::ostream &, const Parameters &);
+
+private:
+  constexpr static uint32_t MAXIMUM = 65535;
+
+  std::array<uint32_t, CAPACITY> values_{};
+  uint32_t subparameters_ = 0;
+  uint8_t size_ = 0;
+};
+
+/*
+ * everything collected between the introducer and the final byte of an
+ * escape, CSI or DCS sequence.
+ */
+struct Sequence {
+  constexpr static std::size_t INTERMEDIATES = 2;
+
+  constexpr auto clear() -> void {
+    parameters.clear();
+    marker = '\0';
+    size_ = 0;
+  }
+
+  // private markers ('<', '=', '>' and '?') and intermediate bytes.
+  constexpr auto collect(const char c) -> void {
+    if ('<' <= c && '?' >= c) {
+      marker = c;
+    } else if (INTERMEDIATES > size_) {
+      intermediates_[size_++] = c;
+    }
+  }
+
+  constexpr auto intermediate() const -> char { return 0 < size_ ? intermediates_[0] : '\0'; }
+  constexpr auto intermediates() const -> std::string_view { return {intermediates_.data(), size_}; }
+
+  friend std::ostream & operator << (std::ostream &, const Sequence &);
+
+  Parameters parameters;
+  char marker = '\0';
+
+private:
+  std::array<char, INTERMEDIATES> intermediates_{};
+  uint8_t size_ = 0;
+};
+
+/*
+ * operating system command, the numeric code is parsed as it arrives and
+ * the remaining text is kept in a fixed buffer, truncated at CAPACITY.
+ */
+struct String {
+  constexpr static std::size_t CAPACITY = 1024;
+
+  constexpr auto clear() -> void { code_ = 0; size_ = 0; has_code_ = false; }
+
+  constexpr auto put(const char c) -> void {
+    if ( ! has_code_) {
+      if ('0' <= c && '9' >= c) {
+        code_ = code_ * 10 + (c - '0');
+        return;
+      } else if (';' == c) {
+        has_code_ = true;
+        return;
+      }
+      has_code_ = true;
+    }
+    if (CAPACITY > size_) {
+      text_[size_++] = c;
+    }
+  }
+
+  constexpr auto code() const -> uint32_t { return code_; }
+  constexpr auto text() const -> std::string_view { return {text_.data(), size_}; }
+
+private:
+  std::array<char, CAPACITY> text_{};
+  uint32_t code_ = 0;
+  uint16_t size_ = 0;
+  bool has_code_ = false;
+};
+
+inline constexpr Table table = detail::make_table();
+
+constexpr const Transition & transition(const State state, const uint8_t c) {
+  return table[static_cast<std::size_t>(state)][c];
+}
+
+static_assert(State::CSI_ENTRY == transition(State::ESCAPE, '[').state);
+static_assert(Action::CLEAR == transition(State::ESCAPE, '[').entry);
+static_assert(Action::OSC_END == transition(State::OSC_STRING, '\e').exit);
+static_assert(Action::CSI_DISPATCH == transition(State::CSI_PARAM, 'm').action);
+static_assert(Action::PRINT == transition(State::GROUND, 0xe2).action);
+
+} // end of namespace parser
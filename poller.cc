@@ -11,10 +11,65 @@
 
 using namespace std::chrono_literals;
 
+TimePoint Budget::deadline(const TimePoint & now, const std::optional<TimePoint> & next) {
+  Duration slice = stats_.frame - stats_.render - RESERVE;
+  if (next.has_value()) {
+    slice = std::min<Duration>(slice, next.value() - now);
+  }
+  slice = std::max(slice, MINIMUM);
+  stats_.slice = slice;
+  ++stats_.slices;
+  return now + slice;
+}
+
+uint64_t Budget::quota(const TimePoint & deadline) const {
+  if (0 >= stats_.nanoseconds_per_byte) {
+    return 0;
+  }
+  const Duration remaining = deadline - std::chrono::steady_clock::now();
+  if (0ns >= remaining) {
+    return 0;
+  }
+  return remaining.count() / stats_.nanoseconds_per_byte;
+}
+
+/* exponential moving averages, recent frames weight 1/8 */
+void Budget::parsed(const uint64_t bytes, const Duration & duration, const bool expired) {
+  stats_.bytes += bytes;
+  stats_.expired += expired;
+  if (0 < bytes) {
+    const double cost = static_cast<double>(duration.count()) / bytes;
+    stats_.nanoseconds_per_byte = 0 == stats_.nanoseconds_per_byte ? cost
+      : stats_.nanoseconds_per_byte + (cost - stats_.nanoseconds_per_byte) / 8;
+  }
+}
+
+void Budget::rendered(const Duration & duration) {
+  stats_.render += (duration - stats_.render) / 8;
+  ++stats_.renders;
+}
+
+std::ostream & operator << (std::ostream & o, const Budget::Stats & s) {
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+  o << "frame " << duration_cast<microseconds>(s.frame).count() << "us"
+    << ", render " << duration_cast<microseconds>(s.render).count() << "us"
+    << ", slice " << duration_cast<microseconds>(s.slice).count() << "us"
+    << ", " << s.nanoseconds_per_byte << "ns/byte"
+    << ", " << s.bytes << " bytes"
+    << ", " << s.expired << "/" << s.slices << " slices expired";
+  return o;
+}
+
 void Poller::add(int fd, std::unique_ptr<Events> && events) {
   assert(static_cast<bool>(events));
   files_.push_back({.fd = fd, .events = events->events, .revents = 0,});
+  events->budget = &budget_;
   if (0ms < events->frequency) {
+    /* the shortest painting timer period paces frames */
+    if (events->paints && (0ns == budget_.stats().frame || budget_.stats().frame > events->frequency)) {
+      budget_.frame(events->frequency);
+    }
     events->next = std::chrono::steady_clock::now() + events->frequency;
     events->timeout();
   }
@@ -38,6 +93,10 @@ void Poller::poll() {
   }
 #endif
   while (running_) {
+    for (std::size_t index = 0; index < files_.size(); ++index) {
+      events_[index]->prepare();
+      files_[index].events = events_[index]->events;
+    }
     const int result = ppoll(files_.data(), files_.size(), &time_, &sigmask);
     bool done;
     do {
@@ -48,18 +107,24 @@ void Poller::poll() {
         auto & task = *events_[index];
         if (0ms < task.frequency) {
           if (now >= task.next) {
-            task.next = std::chrono::steady_clock::now() + task.frequency;
+            const auto begin = std::chrono::steady_clock::now();
+            task.next = begin + task.frequency;
             task.timeout();
+            if (task.paints) {
+              budget_.rendered(std::chrono::steady_clock::now() - begin);
+            }
           }
           if ( ! next.has_value() || next.value() > task.next) {
             next = task.next;
           }
         }
       }
+      const auto start = std::chrono::steady_clock::now();
       if (0 < result) {
+        const TimePoint deadline = budget_.deadline(start, next);
         for (std::size_t index = 0; index < files_.size(); ++index) {
           if (0 != (files_[index].revents & POLLIN)) {
-            done &= events_[index]->pollin(next);
+            done &= events_[index]->pollin(deadline);
           }
           if (0 != (files_[index].revents & POLLOUT)) {
             events_[index]->pollout();
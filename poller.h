@@ -6,6 +6,7 @@
 #include <chrono>
 #include <memory>
 #include <optional>
+#include <ostream>
 #include <vector>
 
 #include <poll.h>
@@ -15,19 +16,113 @@
 /* restrict constructor to unique_ptr only */
 using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
 
+/*
+ * splits each frame between parsing and everything else.
+ *
+ * timers which paint are measured, what is left of the frame but for a
+ * reserve for input and other file descriptors becomes the parser's slice,
+ * which is also never allowed to run past the next timer. the parser reports how many bytes it
+ * consumed and for how long, so it can estimate how many bytes fit in the
+ * remaining slice and avoid reading the clock after every character.
+ */
+struct Budget {
+  using Duration = std::chrono::nanoseconds;
+
+  struct Stats {
+    Duration frame{0};
+    Duration render{0};
+    Duration slice{0};
+    double nanoseconds_per_byte = 0;
+    uint64_t bytes = 0;
+    /* slices granted and slices which ran until the deadline */
+    uint64_t slices = 0;
+    uint64_t expired = 0;
+    /* times the painting timers ran, each one drains what was parsed before it */
+    uint64_t renders = 0;
+    friend std::ostream & operator << (std::ostream &, const Stats &);
+  };
+
+  /* the instant parsing should yield, given the next timer */
+  auto deadline(const TimePoint &, const std::optional<TimePoint> &) -> TimePoint;
+  /* how many bytes are expected to be parsed before the deadline */
+  auto quota(const TimePoint &) const -> uint64_t;
+
+  auto frame(const Duration & d) -> void { stats_.frame = d; }
+  auto parsed(const uint64_t, const Duration &, const bool) -> void;
+  auto rendered(const Duration &) -> void;
+  auto stats() const -> const Stats & { return stats_; }
+
+private:
+  /* time left for input and other file descriptors */
+  constexpr static Duration RESERVE = std::chrono::milliseconds(1);
+  /* a slice is never shorter than this, even if a frame ends up late */
+  constexpr static Duration MINIMUM = std::chrono::milliseconds(2);
+
+  Stats stats_;
+};
+
+/*
+ * a parser's share of a frame, reads the clock only once the bytes the
+ * budget expects to fit were parsed and reports the outcome when it ends.
+ */
+struct Slice {
+  ~Slice() {
+    if (nullptr != budget_) {
+      budget_->parsed(bytes, std::chrono::steady_clock::now() - start_, expired);
+    }
+  }
+
+  Slice(Budget * const budget, const std::optional<TimePoint> & deadline) :
+    budget_(budget), deadline_(deadline) {
+    if (nullptr != budget_ && deadline_.has_value()) {
+      quota_ = budget_->quota(deadline_.value());
+    }
+  }
+
+  Slice(const Slice &) = delete;
+  Slice & operator = (const Slice &) = delete;
+
+  auto expire() -> bool {
+    if ( ! deadline_.has_value() || quota_ > bytes) {
+      return false;
+    }
+    if (deadline_.value() <= std::chrono::steady_clock::now()) {
+      expired = true;
+      return true;
+    }
+    quota_ = bytes + (nullptr != budget_ ? budget_->quota(deadline_.value()) : 0);
+    return false;
+  }
+
+  uint64_t bytes = 0;
+  bool expired = false;
+
+private:
+  Budget * const budget_ = nullptr;
+  const std::optional<TimePoint> deadline_;
+  const TimePoint start_ = std::chrono::steady_clock::now();
+  uint64_t quota_ = 0;
+};
+
 struct Events {
 using Frequency = std::chrono::milliseconds;
   virtual ~Events() { }
   Events(const short e) : events(e) { }
-  Events(const Frequency & f) : frequency(f) { }
+  Events(const Frequency & f, const bool p = false) : frequency(f), paints(p) { }
   virtual auto pollerr() -> void { }
   virtual auto pollhup() -> void { }
   virtual auto pollin(const std::optional<TimePoint> & t) -> bool { return true; }
   virtual auto pollout() -> void { }
+  /* called before each poll, may change events */
+  virtual auto prepare() -> void { }
   virtual auto timeout() -> void { }
-  const short events = 0;
+  short events = 0;
   const Frequency frequency{0};
+  /* a timer painting frames, which the budget measures */
+  const bool paints = false;
   TimePoint next;
+  /* set by the poller */
+  Budget * budget = nullptr;
 };
 
 struct Poller {
@@ -43,6 +138,8 @@ struct Poller {
   }
 
   void add(int fd, std::unique_ptr<Events> && events);
+  auto budget() const -> const Budget & { return budget_; }
+  auto is_running() const -> bool { return running_; }
   void off() { running_ = false; }
   void on() { running_ = true; }
   void poll();
@@ -51,5 +148,6 @@ private:
   std::vector<struct pollfd> files_ = {};
   std::vector<std::unique_ptr<Events>> events_ = {};
   const struct timespec time_;
+  Budget budget_;
   std::atomic_bool running_ = false;
 };
@@ -0,0 +1,70 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+
+/*
+ * bounded lock free single producer single consumer queue.
+ *
+ * slots are written and read in place, the producer fills the slot returned
+ * by `back` and makes it visible with `push`, the consumer reads the slot
+ * returned by `front` and releases it with `pop`. both return nullptr when
+ * the queue is full or empty respectively.
+ */
+template <typename T, std::size_t N>
+struct SPSCQueue {
+  static_assert(0 < N && 0 == (N & (N - 1)), "capacity must be a power of two");
+
+  /* producer */
+  auto back() -> T * {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (N <= tail - head_cache_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (N <= tail - head_cache_) {
+        return nullptr;
+      }
+    }
+    return &slots_[tail & (N - 1)];
+  }
+
+  auto push() -> void {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /* consumer */
+  auto front() -> T * {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return nullptr;
+      }
+    }
+    return &slots_[head & (N - 1)];
+  }
+
+  auto pop() -> void {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /* approximate, exact only from either side while the other is idle */
+  auto size() const -> std::size_t {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  constexpr static std::size_t capacity() { return N; }
+
+private:
+  constexpr static std::size_t CACHE_LINE = 64;
+
+  /* indices grow monotonically, slots are addressed modulo N */
+  alignas(CACHE_LINE) std::atomic<std::size_t> head_ = 0;
+  std::size_t tail_cache_ = 0; /* consumer's copy of tail_ */
+  alignas(CACHE_LINE) std::atomic<std::size_t> tail_ = 0;
+  std::size_t head_cache_ = 0; /* producer's copy of head_ */
+  alignas(CACHE_LINE) std::array<T, N> slots_;
+};
@@ -0,0 +1,124 @@
+// Copyright Daniel Morilha 2025
+
+#include <iomanip>
+#include <iostream>
+
+#include <cassert>
+#include <cstring>
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "recording.h"
+
+namespace recording {
+
+namespace {
+constexpr char MAGIC[] = "moonshot recording 1\n";
+} // end of annonymous namespace
+
+Writer::Writer(const std::string & path) : file_(path, std::ios::binary | std::ios::trunc) {
+  if ( ! file_) {
+    std::cerr << "failed to open " << path << " for recording" << std::endl;
+    return;
+  }
+  file_.write(MAGIC, sizeof(MAGIC) - 1);
+}
+
+void Writer::write(const char * const data, const std::size_t size) {
+  if ( ! file_ || 0 == size) {
+    return;
+  }
+  const Chunk chunk{
+    .nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count()),
+    .size = static_cast<uint32_t>(size),
+  };
+  file_.write(reinterpret_cast<const char *>(&chunk.nanoseconds), sizeof(chunk.nanoseconds));
+  file_.write(reinterpret_cast<const char *>(&chunk.size), sizeof(chunk.size));
+  file_.write(data, size);
+}
+
+Reader::Reader(const std::string & path) : file_(path, std::ios::binary) {
+  std::array<char, sizeof(MAGIC) - 1> magic{};
+  file_.read(magic.data(), magic.size());
+  if ( ! file_ || 0 != memcmp(magic.data(), MAGIC, magic.size())) {
+    std::cerr << path << " is not a recording" << std::endl;
+    file_.setstate(std::ios::failbit);
+  }
+}
+
+bool Reader::next(Chunk & chunk) {
+  file_.read(reinterpret_cast<char *>(&chunk.nanoseconds), sizeof(chunk.nanoseconds));
+  file_.read(reinterpret_cast<char *>(&chunk.size), sizeof(chunk.size));
+  if ( ! file_) {
+    return false;
+  }
+  data_.resize(chunk.size);
+  file_.read(data_.data(), chunk.size);
+  return static_cast<bool>(file_);
+}
+
+Player::Player(const std::string & path, const double speed, const int fd) :
+  reader_(path), speed_(speed), fd_(fd) {
+  thread_ = std::thread(&Player::run, this);
+}
+
+Player::~Player() {
+  running_.store(false, std::memory_order_release);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void Player::run() {
+  const Clock::time_point start = Clock::now();
+  std::array<char, 1024> replies;
+  Chunk chunk;
+  while (running_.load(std::memory_order_acquire) && reader_.next(chunk)) {
+    if (0 < speed_) {
+      std::this_thread::sleep_until(start + std::chrono::nanoseconds(
+            static_cast<uint64_t>(chunk.nanoseconds / speed_)));
+    }
+    for (uint32_t offset = 0; chunk.size > offset; ) {
+      const ssize_t result = ::write(fd_, reader_.data() + offset, chunk.size - offset);
+      if (0 > result) {
+        assert(EINTR == errno);
+        continue;
+      }
+      offset += result;
+    }
+    bytes_.fetch_add(chunk.size, std::memory_order_relaxed);
+    /* discards what the terminal answers, device status reports and such */
+    while (0 < recv(fd_, replies.data(), replies.size(), MSG_DONTWAIT)) { }
+  }
+  shutdown(fd_, SHUT_WR);
+}
+
+void Report::frame(const Duration & duration) {
+  ++frames;
+  const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+  std::size_t bucket = 0;
+  for (; BUCKETS.size() > bucket && BUCKETS[bucket] <= milliseconds; ++bucket) { }
+  ++histogram[bucket];
+}
+
+std::ostream & operator << (std::ostream & o, const Report & r) {
+  const std::chrono::duration<double> elapsed = Clock::now() - r.start;
+  o << r.bytes << " bytes in " << elapsed.count() << "s, "
+    << (r.bytes / elapsed.count() / (1024 * 1024)) << " MB/s" << std::endl
+    << r.frames << " frames, " << (r.frames / elapsed.count()) << " fps" << std::endl;
+  for (std::size_t i = 0; r.histogram.size() > i; ++i) {
+    if (Report::BUCKETS.size() > i) {
+      o << "  < " << std::setw(3) << Report::BUCKETS[i] << "ms ";
+    } else {
+      o << "  >= " << std::setw(2) << Report::BUCKETS.back() << "ms ";
+    }
+    o << std::setw(8) << r.histogram[i] << std::endl;
+  }
+  o << "checksum " << std::hex << std::setw(16) << std::setfill('0') << r.checksum
+    << std::dec << std::setfill(' ');
+  return o;
+}
+
+} // end of namespace recording
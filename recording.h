@@ -0,0 +1,95 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+/*
+ * Recording and replaying the bytes a child writes to the pty.
+ *
+ * A recording is a header followed by chunks, each one the outcome of a
+ * read: the nanoseconds elapsed since the recording started, the size and
+ * the raw bytes. Replaying writes the chunks into a socket which takes the
+ * place of the pty, either honoring the original timing scaled by a speed
+ * or as fast as the terminal consumes them.
+ */
+namespace recording {
+
+using Clock = std::chrono::steady_clock;
+
+struct Chunk {
+  uint64_t nanoseconds = 0;
+  uint32_t size = 0;
+};
+
+struct Writer {
+  Writer(const std::string &);
+  auto write(const char * const, const std::size_t) -> void;
+
+private:
+  std::ofstream file_;
+  const Clock::time_point start_ = Clock::now();
+};
+
+struct Reader {
+  Reader(const std::string &);
+  /* the next chunk, its bytes are kept in data until the following call */
+  auto next(Chunk &) -> bool;
+  auto data() const -> const char * { return data_.data(); }
+  explicit operator bool () const { return static_cast<bool>(file_); }
+
+private:
+  std::ifstream file_;
+  std::vector<char> data_;
+};
+
+/* replays a recording into fd from its own thread, shutting it down at the end */
+struct Player {
+  ~Player();
+  Player(const std::string &, const double speed, const int fd);
+
+  Player(const Player &) = delete;
+  Player & operator = (const Player &) = delete;
+
+  auto bytes() const -> uint64_t { return bytes_.load(std::memory_order_relaxed); }
+
+private:
+  auto run() -> void;
+
+  Reader reader_;
+  /* 0 replays as fast as possible */
+  const double speed_ = 0;
+  const int fd_ = -1;
+  std::atomic<uint64_t> bytes_ = 0;
+  std::atomic_bool running_ = true;
+  std::thread thread_;
+};
+
+/* throughput and frame times measured while replaying */
+struct Report {
+  using Duration = std::chrono::nanoseconds;
+
+  /* upper bounds in milliseconds, the last bucket is unbounded */
+  constexpr static std::array<uint16_t, 7> BUCKETS{1, 2, 4, 8, 16, 32, 64};
+
+  auto frame(const Duration &) -> void;
+
+  uint64_t bytes = 0;
+  uint64_t checksum = 0;
+  uint64_t frames = 0;
+  const Clock::time_point start = Clock::now();
+  std::array<uint64_t, BUCKETS.size() + 1> histogram{};
+
+  friend std::ostream & operator << (std::ostream &, const Report &);
+};
+
+} // end of namespace recording
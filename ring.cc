@@ -0,0 +1,95 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+#include <bit>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/uio.h>
+
+#include "ring.h"
+
+std::ostream & operator << (std::ostream & o, const ReadBuffer::Stats & s) {
+  o << s.bytes << " bytes in " << s.reads << " reads"
+    << ", " << (0 < s.reads ? s.bytes / s.reads : 0) << " bytes/read"
+    << ", " << s.capacity << " bytes buffer";
+  return o;
+}
+
+ReadBuffer::ReadBuffer(const std::size_t maximum) {
+  limit(maximum);
+  reallocate(MINIMUM);
+}
+
+void ReadBuffer::limit(const std::size_t maximum) {
+  maximum_ = std::bit_ceil(std::max(maximum, MINIMUM));
+  if (maximum_ < capacity_ && empty()) {
+    reallocate(maximum_);
+  }
+}
+
+void ReadBuffer::reallocate(const std::size_t capacity) {
+  assert(0 == (capacity & (capacity - 1)));
+  assert(size_ <= capacity);
+  std::unique_ptr<char[]> data = std::make_unique_for_overwrite<char[]>(capacity);
+  if (0 < size_) {
+    /* unwraps what is left */
+    const std::size_t first = std::min(size_, capacity_ - head_);
+    std::memcpy(data.get(), data_.get() + head_, first);
+    std::memcpy(data.get() + first, data_.get(), size_ - first);
+  }
+  data_ = std::move(data);
+  capacity_ = capacity;
+  head_ = 0;
+  reported_capacity_.store(capacity_, std::memory_order_relaxed);
+}
+
+ssize_t ReadBuffer::read(const int fd) {
+  if (filled_ && maximum_ > capacity_) {
+    reallocate(capacity_ * 2);
+  } else if (empty() && MINIMUM < capacity_ && capacity_ / 8 > last_) {
+    reallocate(capacity_ / 2);
+  }
+
+  const std::size_t available = capacity_ - size_;
+  if (0 == available) {
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  const std::size_t tail = (head_ + size_) & (capacity_ - 1);
+  const std::size_t first = std::min(available, capacity_ - tail);
+  struct iovec vector[2] = {
+    {.iov_base = data_.get() + tail, .iov_len = first,},
+    {.iov_base = data_.get(), .iov_len = available - first,},
+  };
+
+  const ssize_t result = ::readv(fd, vector, available > first ? 2 : 1);
+  if (0 < result) {
+    size_ += result;
+    last_ = result;
+    filled_ = available == static_cast<std::size_t>(result);
+    bytes_.fetch_add(result, std::memory_order_relaxed);
+    reads_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    filled_ = false;
+  }
+  return result;
+}
+
+void ReadBuffer::consume(const std::size_t size) {
+  assert(size_ >= size);
+  size_ -= size;
+  /* keeps the free space contiguous */
+  head_ = 0 == size_ ? 0 : (head_ + size) & (capacity_ - 1);
+}
+
+ReadBuffer::Stats ReadBuffer::stats() const {
+  return Stats{
+    .bytes = bytes_.load(std::memory_order_relaxed),
+    .reads = reads_.load(std::memory_order_relaxed),
+    .capacity = reported_capacity_.load(std::memory_order_relaxed),
+  };
+}
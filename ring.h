@@ -0,0 +1,78 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+
+/*
+ * ring buffer the child's output is read into.
+ *
+ * reads fill all the free space at once through readv, wrapping around the
+ * end if needed. when a read fills it, the next one doubles the capacity, up
+ * to a maximum, so bulk output takes few large reads while an idle terminal
+ * shrinks back to a page. bytes are consumed from `front`, which may need
+ * two calls when they wrap, incomplete utf-8 sequences in between are left
+ * to the decoder.
+ */
+struct ReadBuffer {
+  constexpr static std::size_t MINIMUM = 4096;
+  constexpr static std::size_t MAXIMUM = 1 << 20;
+
+  /* totals since the buffer was created */
+  struct Stats {
+    uint64_t bytes = 0;
+    uint64_t reads = 0;
+    std::size_t capacity = 0;
+
+    friend std::ostream & operator << (std::ostream &, const Stats &);
+  };
+
+  ReadBuffer(const std::size_t maximum = MAXIMUM);
+
+  ReadBuffer(const ReadBuffer &) = delete;
+  ReadBuffer & operator = (const ReadBuffer &) = delete;
+
+  /* reads into the free space, with the semantics of read(2) */
+  auto read(const int) -> ssize_t;
+
+  /* contiguous bytes not yet consumed */
+  auto front() const -> std::span<const char> {
+    return {data_.get() + head_, std::min(size_, capacity_ - head_)};
+  }
+  auto consume(const std::size_t) -> void;
+
+  auto empty() const -> bool { return 0 == size_; }
+  auto size() const -> std::size_t { return size_; }
+
+  /* rounded up to a power of two, no less than MINIMUM */
+  auto limit(const std::size_t) -> void;
+  auto maximum() const -> std::size_t { return maximum_; }
+
+  /* safe to call from other threads */
+  auto stats() const -> Stats;
+
+private:
+  auto reallocate(const std::size_t) -> void;
+
+  std::unique_ptr<char[]> data_;
+  std::size_t capacity_ = 0;
+  std::size_t maximum_ = 0;
+  std::size_t head_ = 0;
+  std::size_t size_ = 0;
+  /* bytes the last read returned and whether it filled the free space */
+  std::size_t last_ = 0;
+  bool filled_ = false;
+
+  std::atomic<uint64_t> bytes_ = 0;
+  std::atomic<uint64_t> reads_ = 0;
+  std::atomic<std::size_t> reported_capacity_ = 0;
+};
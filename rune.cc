@@ -1,8 +1,10 @@
 // Copyright Daniel Morilha 2025
 
-#include <ostream>
+#include <algorithm>
 #include <array>
+#include <ostream>
 
+#include <cmath>
 #include <cstring>
 
 #include "rune.h"
@@ -24,34 +26,115 @@ std::ostream & operator << (std::ostream & o, const Rune & rune) {
 bool Rune::iscontrol() const { return std::iscntrl(character, locale_); }
 
 bool Rune::operator < (const Rune & o) const {
-  return character < o.character || style < o.style;
+  return character < o.character || (character == o.character && style() < o.style());
+}
+
+std::size_t AttributesTable::Hash::operator () (const Attributes & a) const {
+  /* fnv-1a over the fields, the floats by their bits */
+  std::size_t hash = 0xcbf29ce484222325;
+  const auto combine = [&hash](const void * const data, const std::size_t size) {
+    const unsigned char * const bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; size > i; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+  };
+  combine(&a.background, sizeof(a.background));
+  combine(&a.foreground, sizeof(a.foreground));
+  const std::array<uint8_t, 4> rest{
+    static_cast<uint8_t>(a.style), static_cast<uint8_t>(a.blink), a.crossout, a.underline,
+  };
+  combine(rest.data(), rest.size());
+  return hash;
+}
+
+AttributesTable::AttributesTable() {
+  container_.emplace_back();
+  ids_.emplace(container_.front(), 0);
+}
+
+AttributesTable & AttributesTable::instance() {
+  static AttributesTable table;
+  return table;
+}
+
+namespace {
+
+/* rounds every channel to the closest of 2^bits levels */
+Attributes quantize(Attributes attributes, const unsigned bits) {
+  const float levels = (1 << bits) - 1;
+  const auto round = [levels](float & channel) {
+    channel = std::round(std::clamp(channel, 0.f, 1.f) * levels) / levels;
+  };
+  for (Color * const color : {&attributes.background, &attributes.foreground}) {
+    round(color->red);
+    round(color->green);
+    round(color->blue);
+    round(color->alpha);
+  }
+  return attributes;
+}
+
+} // end of annonymous namespace
+
+std::optional<uint32_t> AttributesTable::find(const Attributes & attributes) const {
+  const auto iterator = ids_.find(attributes);
+  if (ids_.end() == iterator) {
+    return std::nullopt;
+  }
+  return iterator->second;
+}
+
+uint32_t AttributesTable::emplace(const Attributes & attributes) {
+  const auto [iterator, inserted] = ids_.emplace(attributes, container_.size());
+  if (inserted) {
+    container_.push_back(attributes);
+  }
+  return iterator->second;
+}
+
+uint32_t AttributesTable::intern(const Attributes & attributes) {
+  AttributesTable & table = instance();
+  if (const std::optional<uint32_t> id = table.find(attributes)) {
+    return *id;
+  }
+  if (EXACT > table.container_.size()) {
+    return table.emplace(attributes);
+  }
+  const Attributes rounded = quantize(attributes, 4);
+  if (LIMIT > table.container_.size()) {
+    return table.emplace(rounded);
+  }
+  if (const std::optional<uint32_t> id = table.find(rounded)) {
+    return *id;
+  }
+  return table.emplace(quantize(attributes, 1));
 }
 
-Rune RuneFactory::make(const wchar_t c) {
-  Rune rune(c);
+void RuneFactory::update() {
+  Attributes attributes;
   if (is_bold && is_italic) {
-    rune.style = Style::BOLD_AND_ITALIC;
+    attributes.style = Style::BOLD_AND_ITALIC;
   } else if (is_bold) {
-    rune.style = Style::BOLD;
+    attributes.style = Style::BOLD;
   } else if (is_italic) {
-    rune.style = Style::ITALIC;
+    attributes.style = Style::ITALIC;
   } else {
-    rune.style = Style::REGULAR;
+    attributes.style = Style::REGULAR;
   }
 
   if (invert_colors) {
-    rune.backgroundColor = foreground_color;
-    rune.foregroundColor = background_color;
+    attributes.background = foreground_color;
+    attributes.foreground = background_color;
   } else {
-    rune.backgroundColor = background_color;
-    rune.foregroundColor = foreground_color;
+    attributes.background = background_color;
+    attributes.foreground = foreground_color;
   }
 
-  rune.blink = blink;
-  rune.crossout = crossout;
-  rune.underline = underline;
+  attributes.blink = blink;
+  attributes.crossout = crossout;
+  attributes.underline = underline;
 
-  return rune;
+  attributes_ = AttributesTable::intern(attributes);
 }
 
 void RuneFactory::reset() {
@@ -2,8 +2,12 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include <cstdint>
 #include <cwchar>
 
 #include "types.h"
@@ -23,20 +27,66 @@ enum class Blink {
   FAST,
 };
 
-struct RuneFactory;
-
-struct Rune {
-  Color backgroundColor = colors::black;
-  Color foregroundColor = colors::white;
+/* everything about a cell but its character, interned and shared by id */
+struct Attributes {
+  Color background = colors::black;
+  Color foreground = colors::white;
   Style style = Style::REGULAR;
   Blink blink = Blink::STEADY;
   bool crossout = false;
   bool underline = false;
+
+  bool operator == (const Attributes &) const = default;
+};
+
+/*
+ * the table of distinct attributes seen so far, id 0 being the defaults.
+ * ids are never released, so the table is bounded instead: past EXACT
+ * entries colors are rounded to 4 bits a channel, and once LIMIT is reached
+ * attributes not already interned take 1 bit a channel, 8 colors, which
+ * adds at most 3072 more entries. gradients then share ids.
+ */
+struct AttributesTable {
+  constexpr static std::size_t EXACT = 1 << 15;
+  constexpr static std::size_t LIMIT = 1 << 16;
+
+  static auto at(const uint32_t id) -> const Attributes & { return instance().container_[id]; }
+  static auto intern(const Attributes &) -> uint32_t;
+  static auto size() -> std::size_t { return instance().container_.size(); }
+
+private:
+  auto emplace(const Attributes &) -> uint32_t;
+  auto find(const Attributes &) const -> std::optional<uint32_t>;
+
+  struct Hash {
+    auto operator () (const Attributes &) const -> std::size_t;
+  };
+
+  AttributesTable();
+  static auto instance() -> AttributesTable &;
+
+  std::vector<Attributes> container_;
+  std::unordered_map<Attributes, uint32_t, Hash> ids_;
+};
+
+struct RuneFactory;
+
+/* a cell, 8 bytes, the character and the id of its attributes */
+struct Rune {
   wchar_t character = L'\0';
 
   Rune() = default;
   Rune(const wchar_t c) : character(c) { }
-
+  Rune(const wchar_t c, const uint32_t id) : character(c), attributes_(id) { }
+
+  auto attributes() const -> const Attributes & { return AttributesTable::at(attributes_); }
+  auto background() const -> const Color & { return attributes().background; }
+  auto blink() const -> Blink { return attributes().blink; }
+  auto crossout() const -> bool { return attributes().crossout; }
+  auto foreground() const -> const Color & { return attributes().foreground; }
+  auto id() const -> uint32_t { return attributes_; }
+  auto style() const -> Style { return attributes().style; }
+  auto underline() const -> bool { return attributes().underline; }
   bool isalphanumeric() const { return std::isalnum(character, locale_); }
   bool isalpha() const { return std::isalpha(character, locale_); }
   bool isblank() const { return std::isblank(character, locale_); }
@@ -61,12 +111,21 @@ struct Rune {
 
 private:
   static const std::locale locale_;
+
+  uint32_t attributes_ = 0;
 };
 
+static_assert(8 == sizeof(Rune));
+
+/*
+ * the attributes for the runes to come, changes to the fields below take
+ * effect once update interns them, once per SGR rather than per rune.
+ */
 struct RuneFactory {
-  Rune make(const wchar_t);
+  Rune make(const wchar_t c) const { Rune rune(c); rune.attributes_ = attributes_; return rune; }
 
   void reset();
+  void update();
   void reset_background_color() { background_color = colors::black; }
   void reset_foreground_color() { foreground_color = colors::white; }
 
@@ -78,6 +137,9 @@ struct RuneFactory {
   bool is_italic = false;
   bool underline = false;
   Blink blink = Blink::STEADY;
+
+private:
+  uint32_t attributes_ = 0;
 };
 
 } // end of rune namespace
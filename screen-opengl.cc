@@ -0,0 +1,1268 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+#include <iostream>
+
+#include <cassert>
+
+#include <GL/gl.h>
+
+#include "character-map.h"
+#include "opengl.h"
+#include "pages.h"
+#include "screen.h"
+#include "types.h"
+#include "wayland.h"
+
+/*
+ * the opengl backend, the screen renders glyphs into pages backed by
+ * framebuffers and presents them on a wayland surface.
+ */
+struct Screen::Backend {
+  Backend(std::unique_ptr<wayland::Surface> && s) : surface(std::move(s)) { }
+
+  CharacterMap characters;
+  Pages pages{/* total number of entries, where 2 is the minimum */ 2};
+  /* the pages of whichever screen, primary or alternative, is not shown */
+  Pages inactive{2};
+  Damage damage;
+  opengl::Shader glProgram;
+  std::unique_ptr<wayland::Surface> surface;
+};
+
+Screen Screen::New(const wayland::Connection & connection) {
+  auto egl = connection.egl();
+  std::unique_ptr<wayland::Surface> surface = connection.surface(std::move(egl));
+
+  surface->setTitle("Moonshot");
+
+  Screen screen(std::make_unique<Backend>(std::move(surface)));
+
+  screen.makeCurrent();
+  screen.swapBuffers();
+
+  connection.roundtrip();
+
+  screen.backend_->glProgram.vertex(
+      "#version 120\n"
+      "attribute vec4 vpos;\n"
+      "varying vec2 texcoord;\n"
+      "void main()\n"
+      "{\n"
+      "    texcoord = vpos.zw;\n"
+      "    gl_Position = vec4(vpos.xy, 0, 1);\n"
+      "}\n")
+    .fragment(
+      "#version 120\n"
+      "uniform sampler2D texture;\n"
+      "uniform vec3 background;\n"
+      "uniform vec3 color;\n"
+      "varying vec2 texcoord;\n"
+      "void main()\n"
+      "{\n"
+      "    vec3 character = texture2D(texture, texcoord).rgb;\n"
+      "    gl_FragColor = vec4(mix(background, color, character), 1.0);\n"
+      "}\n")
+    .link();
+
+  screen.backend_->pages.glProgram_.vertex(
+      "#version 120\n"
+      "attribute vec4 vpos;\n"
+      "varying vec2 texcoord;\n"
+      "void main()\n"
+      "{\n"
+      "    texcoord = vpos.zw;\n"
+      "    gl_Position = vec4(vpos.xy, 0, 1);\n"
+      "}\n")
+    .fragment(
+      "#version 120\n"
+      "uniform sampler2D texture;\n"
+      "varying vec2 texcoord;\n"
+      "void main()\n"
+      "{\n"
+      "    gl_FragColor = texture2D(texture, texcoord);\n"
+      "}\n")
+    .link();
+
+  return screen;
+}
+
+void Screen::setTitle(const std::string & title) {
+  assert(backend_->surface);
+  if ( ! title.empty()) {
+    title_ = title;
+    if ( ! search_) {
+      backend_->surface->setTitle(title);
+    }
+  } else {
+    std::cerr << __FILE__ << ":" << __LINE__ << " " << __func__ << " empty title is not supported." << std::endl;
+  }
+}
+
+void Screen::show_title(const std::string & title) {
+  backend_->surface->setTitle(title);
+}
+
+Screen::Screen(std::unique_ptr<Backend> && backend) : backend_(std::move(backend)) {
+  assert(static_cast<bool>(backend_->surface));
+  backend_->surface->onResize = std::bind_front(&Screen::resize, this);
+}
+
+Screen::~Screen() = default;
+
+Screen::Screen(Screen && other) : backend_(std::move(other.backend_)) { }
+
+void Screen::makeCurrent() const {
+  backend_->surface->egl().makeCurrent();
+}
+
+void Screen::reset(const uint16_t width, const uint16_t height) {
+  /**
+   * Pages::reset currently breaks if height
+   * is anything different than surface_height
+   */
+  backend_->pages.reset(width, height);
+
+  { /* dimensions */
+    freetype::Face & face = backend_->characters.font().regular();
+    dimensions_.reset(face.descender(), face.glyphWidth(), face.lineHeight(), width, height);
+  }
+}
+
+void Screen::swap_pages(const bool clear) {
+  backend_->pages.swap(backend_->inactive);
+  if (clear) {
+    backend_->pages.clear(dimensions_.surface_width(), dimensions_.surface_height());
+  }
+}
+
+void Screen::clear() {
+  opengl::clear(dimensions_.surface_width(), dimensions_.surface_height(), colors::black);
+  swapBuffers();
+}
+
+void Screen::changeScrollY(int32_t value) {
+  value *= -2;
+  const uint64_t new_value = dimensions_.scroll_y() + value;
+  if (0 < value || dimensions_.scroll_y() > value * -1) {
+    dimensions_.scroll_y(new_value);
+    repaint_ = FULL;
+  } else if (0 < dimensions_.scroll_y()) {
+    dimensions_.scroll_y(0);
+    repaint_ = FULL;
+  }
+  draw_scrollback();
+}
+
+/*
+ * covers the screen scrolled back with pages of scrollback. pages next to
+ * what is covered already are drawn a screen at a time, anything farther
+ * is drawn right where it is, leaving a gap below filled the same way
+ * once scrolled into. pages more than a screen away are dropped, so only a
+ * few screens worth of them are ever kept, however far a jump goes.
+ */
+void Screen::draw_scrollback() {
+  if (0 == dimensions_.scroll_y()) {
+    return;
+  }
+  Pages & pages = backend_->pages;
+  const int64_t height = dimensions_.surface_height();
+  const int64_t line_height = dimensions_.line_height();
+  /* where the screen starts, below the last row of scrollback */
+  const int64_t last = dimensions_.scrollback_lines() * line_height;
+  const int64_t top = last - static_cast<int64_t>(dimensions_.scroll_y());
+  const int64_t bottom = top + height;
+  pages.drop_scrollback(top - height, bottom + height);
+
+  const int64_t live = pages.live_y();
+  if (live <= bottom + height) {
+    /* within a screen of the pages drawn live, drawn up from them */
+    if (pages.scrollback_y() != live) {
+      pages.drop_scrollback();
+    }
+  } else if (pages.scrollback_y() < bottom || pages.front_y() - height > top || pages.front_y() == live) {
+    /* ends up to a screen below, to scroll down into, rows up from the last row of scrollback */
+    pages.drop_scrollback();
+    const int64_t rows = std::max<int64_t>(0, (static_cast<int64_t>(dimensions_.scroll_y()) - 2 * height + line_height - 1) / line_height);
+    recreateFromScrollback(history_.rewind(history_.scrollback_size(), rows).first, last - rows * line_height);
+  }
+
+  while (top < pages.front_y() && 0 < pages.front_index()) {
+    const int64_t y = pages.front_y();
+    recreateFromScrollback(pages.front_index(), y);
+    if (y == pages.front_y()) {
+      break;
+    }
+  }
+}
+
+void Screen::renderCharacter(const Rectangle & target, const rune::Rune & rune, const bool conceal_blinking) {
+  if (conceal_blinking && rune::Blink::STEADY != rune.blink()) {
+    return;
+  }
+  const Character & character = backend_->characters.retrieve(rune);
+  const float vertex_bottom = backend_->pages.scale_height() * (target.y + character.top - (dimensions_.glyph_descender() + character.height));
+  const float vertex_left = backend_->pages.scale_width() * (target.x + character.left);
+  const float vertex_right = backend_->pages.scale_width() * (target.x + character.left + character.width);
+  const float vertex_top = backend_->pages.scale_height() * (target.y + character.top - dimensions_.glyph_descender());
+
+  const float vertices[4][4] = {
+    // vertex a - left top
+    { -1.f + vertex_left, -1.f + vertex_top, 0, 0, },
+    // vertex b - right top
+    { -1.f + vertex_right, -1.f + vertex_top, 1, 0, },
+    // vertex c - right bottom
+    { -1.f + vertex_right, -1.f + vertex_bottom, 1, 1, },
+    // vertex d - left bottom
+    { -1.f + vertex_left, -1.f + vertex_bottom, 0, 1, },}; 
+
+  GLuint vertex_buffer = 0;
+  glGenBuffers(1, &vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+  assert(0 != character.texture);
+  glBindTexture(GL_TEXTURE_2D, character.texture);
+  glActiveTexture(GL_TEXTURE0 + character.texture);
+
+  {
+    auto shader = backend_->glProgram.use();
+    shader.bind(glUniform1i, "texture", 0);
+    shader.bind(glUniform3fv, "background", 1, rune.background());
+    shader.bind(glUniform3fv, "color", 1, rune.foreground());
+    shader.bind(glEnableVertexAttribArray, "vpos");
+    shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  }
+
+  glDeleteBuffers(1, &vertex_buffer);
+  glActiveTexture(GL_TEXTURE0);
+
+  if (rune.crossout()) {
+    const Rectangle crossout {
+      .x = target.x,
+      .y = target.y + dimensions_.line_height() / 2,
+      .width = target.width,
+      .height = 1,
+    };
+    glEnable(GL_SCISSOR_TEST);
+    crossout(glScissor);
+    rune.foreground()(glClearColor);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+  }
+
+  if (rune.underline()) {
+    const Rectangle underline {
+      .x = target.x,
+      .y = target.y + 2,
+      .width = target.width,
+      .height = 1,
+    };
+    glEnable(GL_SCISSOR_TEST);
+    underline(glScissor);
+    rune.foreground()(glClearColor);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+  }
+}
+
+void Screen::renderCharacters(const Rectangle & target, std::span<const rune::Rune> runes, const bool conceal_blinking) {
+  assert(dimensions_.glyph_width() * runes.size() == target.width);
+  Rectangle cell{
+    .x = target.x,
+    .y = target.y,
+    .width = dimensions_.glyph_width(),
+    .height = target.height,
+  };
+
+  glEnable(GL_SCISSOR_TEST);
+  for (const rune::Rune & rune : runes) {
+    cell(glScissor);
+    rune.background()(glClearColor);
+    glClear(GL_COLOR_BUFFER_BIT);
+    cell.x += cell.width;
+  }
+  glDisable(GL_SCISSOR_TEST);
+
+  // one vertex buffer and one program binding for the whole run.
+  GLuint vertex_buffer = 0;
+  glGenBuffers(1, &vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 16, nullptr, GL_STREAM_DRAW);
+
+  {
+    auto shader = backend_->glProgram.use();
+    shader.bind(glUniform1i, "texture", 0);
+    shader.bind(glEnableVertexAttribArray, "vpos");
+    shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4, nullptr);
+
+    cell.x = target.x;
+    for (const rune::Rune & rune : runes) {
+      const bool hidden = conceal_blinking && rune::Blink::STEADY != rune.blink();
+      if ( ! hidden) {
+        const Character & character = backend_->characters.retrieve(rune);
+        const float vertex_bottom = backend_->pages.scale_height() * (cell.y + character.top - (dimensions_.glyph_descender() + character.height));
+        const float vertex_left = backend_->pages.scale_width() * (cell.x + character.left);
+        const float vertex_right = backend_->pages.scale_width() * (cell.x + character.left + character.width);
+        const float vertex_top = backend_->pages.scale_height() * (cell.y + character.top - dimensions_.glyph_descender());
+
+        const float vertices[4][4] = {
+          // vertex a - left top
+          { -1.f + vertex_left, -1.f + vertex_top, 0, 0, },
+          // vertex b - right top
+          { -1.f + vertex_right, -1.f + vertex_top, 1, 0, },
+          // vertex c - right bottom
+          { -1.f + vertex_right, -1.f + vertex_bottom, 1, 1, },
+          // vertex d - left bottom
+          { -1.f + vertex_left, -1.f + vertex_bottom, 0, 1, },};
+
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+
+        assert(0 != character.texture);
+        glBindTexture(GL_TEXTURE_2D, character.texture);
+        glActiveTexture(GL_TEXTURE0 + character.texture);
+        shader.bind(glUniform3fv, "background", 1, rune.background());
+        shader.bind(glUniform3fv, "color", 1, rune.foreground());
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+      }
+      cell.x += cell.width;
+    }
+  }
+
+  glDeleteBuffers(1, &vertex_buffer);
+  glActiveTexture(GL_TEXTURE0);
+
+  cell.x = target.x;
+  glEnable(GL_SCISSOR_TEST);
+  for (const rune::Rune & rune : runes) {
+    const bool hidden = conceal_blinking && rune::Blink::STEADY != rune.blink();
+    if ( ! hidden && rune.crossout()) {
+      const Rectangle crossout {
+        .x = cell.x,
+        .y = cell.y + dimensions_.line_height() / 2,
+        .width = cell.width,
+        .height = 1,
+      };
+      crossout(glScissor);
+      rune.foreground()(glClearColor);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+    if ( ! hidden && rune.underline()) {
+      const Rectangle underline {
+        .x = cell.x,
+        .y = cell.y + 2,
+        .width = cell.width,
+        .height = 1,
+      };
+      underline(glScissor);
+      rune.foreground()(glClearColor);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+    cell.x += cell.width;
+  }
+  glDisable(GL_SCISSOR_TEST);
+}
+
+uint16_t Screen::pushCharacter(rune::Rune rune) {
+  assert(0 < dimensions_.glyph_width());
+  uint16_t columns = 1; 
+  switch (rune.character) {
+  case L'\0':
+    rune.character = L' ';
+    break;
+
+  case L'\t': // horizontal tab
+    columns = 8 - (column() % 8);
+    rune.character = L' ';
+    break;
+
+  default:
+    break;
+  }
+
+  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
+  rectangle.width = dimensions_.glyph_width() * columns;
+
+  {
+    const auto drawer = backend_->pages.draw(rectangle, history_.size());
+    drawer.clear(rune.background());
+    renderCharacter(drawer.target, rune);
+
+    if (rune::Blink::STEADY != rune.blink()) {
+      drawer.create_alternative();
+    }
+
+    if (drawer.alternative()) {
+      drawer.clear(rune.background());
+      renderCharacter(drawer.target, rune, true);
+    }
+
+    Rectangle r{
+      .x = drawer.target.x,
+      .y = overflow(),
+      .width = drawer.target.width,
+      .height = drawer.target.height, };
+
+    backend_->damage.emplace(std::move(r));
+  }
+
+  return columns;
+}
+
+void Screen::pushCharacters(std::span<const rune::Rune> runes) {
+  assert(0 < dimensions_.glyph_width());
+  assert( ! runes.empty());
+
+  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
+  rectangle.width = dimensions_.glyph_width() * runes.size();
+
+  const auto drawer = backend_->pages.draw(rectangle, history_.size());
+  renderCharacters(drawer.target, runes, false);
+
+  const bool blink = std::any_of(runes.begin(), runes.end(),
+      [](const rune::Rune & r) { return rune::Blink::STEADY != r.blink(); });
+  if (blink) {
+    drawer.create_alternative();
+  }
+
+  if (drawer.alternative()) {
+    renderCharacters(drawer.target, runes, true);
+  }
+
+  backend_->damage.emplace(Rectangle{
+    .x = drawer.target.x,
+    .y = overflow(),
+    .width = drawer.target.width,
+    .height = drawer.target.height, });
+}
+
+void Screen::present(const bool force, const bool alternative) {
+  opengl::clear(dimensions_.surface_width(), dimensions_.surface_height(), colors::black);
+#if 1
+  int32_t height = static_cast<int32_t>(dimensions_.line_to_pixel(dimensions_.displayed_lines() + 1));
+  int64_t offset_y = 0;
+  if (0 < dimensions_.scrollback_lines()) {
+    offset_y = dimensions_.scrollback_lines() * dimensions_.line_height();
+  }
+
+  if (0 != dimensions_.scroll_y()) {
+    offset_y -= dimensions_.scroll_y();
+    height = dimensions_.surface_height();
+  } else if (dimensions_.overflow()) {
+    offset_y -= dimensions_.remainder();
+  }
+
+  backend_->pages.repaint(
+    Rectangle{
+      .x = 0,
+      .y = 0,
+      .width = dimensions_.surface_width(),
+      .height = height, },
+    offset_y,
+    alternative);
+
+  if (search_ && history_.is_scrollback_enabled()) {
+    draw_matches(offset_y);
+  }
+#else
+  backend_->pages.paint(0);
+#endif
+
+  if (alternative && 0 == dimensions_.scroll_y()) {
+    draw_cursor(overflow());
+  }
+
+  const bool forceSwapBuffers = force || backend_->damage.empty() || FULL == repaint_;
+  swapBuffers(forceSwapBuffers);
+}
+
+void Screen::swapBuffers(bool fullSwap) {
+  fullSwap |= backend_->damage.area() * 2 >= dimensions_.area();
+  if ( ! fullSwap && ! backend_->damage.empty()) {
+    std::vector<Rectangle> rectangles;
+    backend_->damage.transfer(rectangles);
+    backend_->surface->egl().swapBuffers(rectangles);
+  } else {
+    backend_->surface->egl().swapBuffers();
+  }
+  backend_->damage.clear();
+  ++frames_;
+}
+
+Pages::Drawer::~Drawer() {
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Pages::Drawer::Drawer(const Pages & p, Entry & e, Rectangle && r) : pages_(p), entry_(e), target(std::move(r)) {
+  entry_.framebuffer.bind();
+}
+
+bool Pages::Drawer::alternative() const {
+  const bool result = entry_.alternative;
+  if (result) {
+    entry_.alternative.bind();
+  }
+  return result;
+}
+
+void Pages::Drawer::create_alternative() const {
+  if ( ! entry_.alternative) {
+    entry_.alternative = entry_.framebuffer.clone(pages_.width_, pages_.height_);
+  }
+}
+
+uint32_t Pages::total_height() const {
+  uint32_t result = 0;
+  for (const auto & item : container_) {
+    result += item.area.height;
+  }
+  return result;
+}
+
+void Pages::Drawer::clear(const Color & color) const {
+  glEnable(GL_SCISSOR_TEST);
+  target(glScissor);
+  color(glClearColor);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glDisable(GL_SCISSOR_TEST);
+}
+
+Pages::Drawer Pages::draw(Rectangle_Y rectangle, const uint64_t index) {
+  assert(height_ >= rectangle.height);
+  assert(width_ >= rectangle.width);
+  Entry & entry = update(rectangle, index);
+  return Drawer(*this, entry, static_cast<Rectangle>(rectangle));
+}
+
+Rectangle Pages::blank(const Rectangle_Y & rectangle, const uint64_t index) {
+  const Drawer drawer = draw(rectangle, index);
+  drawer.clear(colors::black);
+  if (drawer.alternative()) {
+    drawer.clear(colors::black);
+  }
+  return drawer.target;
+}
+
+void Pages::clear(const uint16_t width, const uint16_t height) {
+  if (container_.empty() || width != width_ || height != height_) {
+    reset(width, height);
+    return;
+  }
+  container_.erase(std::next(container_.begin()), container_.end());
+  current_ = container_.begin();
+  Entry & entry = *current_;
+  entry.framebuffer.bind();
+  opengl::clear(width_, height_, colors::black);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  entry.alternative = opengl::Framebuffer();
+  entry.area = Rectangle_Y{ .width = width_, };
+  entry.index = 0;
+  entry.scrollback = false;
+}
+
+void Pages::swap(Pages & other) {
+  const bool end = container_.end() == current_,
+        other_end = other.container_.end() == other.current_;
+  /* list nodes move along with the swap, end iterators do not */
+  container_.swap(other.container_);
+  std::swap(current_, other.current_);
+  if (end) {
+    other.current_ = other.container_.end();
+  }
+  if (other_end) {
+    current_ = container_.end();
+  }
+  std::swap(scratch_, other.scratch_);
+  std::swap(height_, other.height_);
+  std::swap(width_, other.width_);
+}
+
+void Pages::reset(const uint16_t width, const uint16_t height) {
+  width_ = width;
+  height_ = height;
+  container_.clear();
+  current_ = container_.end();
+  scratch_ = opengl::Framebuffer();
+}
+
+/*
+ * moves a rectangle of the canvas to start at x, y, gathering it from the
+ * pages it is on into the scratch framebuffer and scattering it back, one
+ * texture copy per page each way.
+ */
+void Pages::move(const Rectangle_Y & source, const int32_t x, const int64_t y) {
+  assert(0 < source.height);
+  assert(height_ >= source.height);
+  assert(width_ >= source.x + source.width);
+  assert(width_ >= x + source.width);
+  if ( ! scratch_) {
+    scratch_ = opengl::Framebuffer::New(width_, height_);
+  }
+
+  /* the part of a page within [top, top + height) */
+  const auto overlap = [this, &source](const Entry & entry, const int64_t top) {
+    return std::make_pair(std::max(top, entry.area.y),
+        std::min(top + source.height, entry.area.y + height_));
+  };
+
+  for (const bool alternative : {false, true}) {
+    if (alternative && ! has_alternative()) {
+      break;
+    }
+
+    for (const Entry & entry : container_) {
+      const auto [a, b] = overlap(entry, source.y);
+      if (a < b) {
+        const opengl::Framebuffer & framebuffer = alternative && entry.alternative ? entry.alternative : entry.framebuffer;
+        scratch_.copy(framebuffer, Rectangle{
+            .x = source.x,
+            .y = static_cast<int32_t>(height_ - (b - entry.area.y)),
+            .width = source.width,
+            .height = static_cast<int32_t>(b - a), },
+          source.x, height_ - (b - source.y));
+      }
+    }
+
+    for (Entry & entry : container_) {
+      const auto [a, b] = overlap(entry, y);
+      if (a < b && ( ! alternative || entry.alternative)) {
+        (alternative ? entry.alternative : entry.framebuffer).copy(scratch_, Rectangle{
+            .x = source.x,
+            .y = static_cast<int32_t>(height_ - (b - y)),
+            .width = source.width,
+            .height = static_cast<int32_t>(b - a), },
+          x, height_ - (b - entry.area.y));
+        entry.area.height = std::max<int32_t>(entry.area.height, b - entry.area.y);
+      }
+    }
+  }
+}
+
+Pages::Entry & Pages::update(Rectangle_Y & rectangle, const uint64_t index) {
+  bool found = false;
+
+  // cache hit, skip a look-up
+  if (container_.end() != current_ && current_->area.y <= rectangle.y && current_->area.y + height_ >= rectangle.y + rectangle.height) {
+    // grow current page area height.
+    const uint64_t new_height = rectangle.y + rectangle.height - current_->area.y;
+    if (current_->area.height < new_height) {
+      current_->area.height = new_height;
+    }
+    found = true;
+
+  // cache miss
+  } else if ( ! container_.empty()) {
+    const Container::const_iterator END = container_.end();
+    Container::iterator iterator = container_.begin();
+    assert(iterator->area.y <= rectangle.y);
+    for (; END != iterator; ++iterator) {
+      if (iterator->area.y <= rectangle.y && iterator->area.y + iterator->area.height > rectangle.y) {
+        // can't grow a previously full buffer
+        assert(iterator->area.y + height_ >= rectangle.y + rectangle.height);
+        current_ = iterator;
+        const uint64_t new_height = rectangle.y + rectangle.height - current_->area.y;
+        if (current_->area.height < new_height) {
+          current_->area.height = new_height;
+        }
+        found = true;
+        break;
+      }
+    }
+  }
+
+  if ( ! found) { 
+    // cap it to the last cap_ pages.
+    if (0 < cap_ && container_.size() >= cap_) {
+      const auto begin = container_.begin();
+      auto end = begin;
+      for (int i = 0; i <= container_.size() - cap_; ++i) {
+        assert(container_.end() != end);
+        ++end;
+      }
+      container_.erase(begin, end);
+    }
+
+    // if it did not find a page, insert a new page at the end.
+    current_ = container_.emplace(container_.end(), new_entry(rectangle, index));
+  }
+  rectangle.y = height_ - (rectangle.y - current_->area.y) - rectangle.height;
+
+  assert(container_.end() != current_);
+  return *current_;
+}
+
+void Pages::repaint(const Rectangle rectangle, const int64_t offset_y, const bool alt) {
+  assert(0 == rectangle.x);
+  assert(width_ >= rectangle.width);
+  const auto END = container_.end();
+  uint16_t y = 0, height = 0;
+  for (auto iterator = container_.begin(); END != iterator; ++iterator) {
+    height += iterator->area.height;
+    if (rectangle.height < height) {
+      height = rectangle.height;
+      break;
+    }
+  }
+
+  if (0 == height) {
+    return;
+  } else if (height_ < height) {
+    height = height_;
+  }
+
+  for (auto iterator = container_.begin(); END != iterator; ++iterator) {
+    if (offset_y > iterator->area.y && offset_y <= iterator->area.y + iterator->area.height) {
+      // from
+      const float w1 = 0;
+      float w2 = iterator->area.width;
+      w2 /= std::min(iterator->area.width, rectangle.width);
+      float z1 = height_ - iterator->area.height;
+      float z2 = z1 + iterator->area.height - (offset_y - iterator->area.y);
+      z1 /= height_;
+      z2 /= height_;
+      // to
+      const uint16_t x1 = iterator->area.x;
+      const uint16_t x2 = x1 + std::min(iterator->area.width, rectangle.width);
+      const uint16_t y1 = y;
+      uint16_t y2 = y1 + iterator->area.height - (offset_y - iterator->area.y);
+      const float vertices[4][4] = {
+        // vertex a - left top
+        { -1 + scale_width() * x1, 1 - scale_height() * y1, w1, z2, },
+        // vertex b - right top
+        { -1 + scale_width() * x2, 1 - scale_height() * y1, w2, z2, },
+        // vertex c - right bottom
+        { -1 + scale_width() * x2, 1 - scale_height() * y2, w2, z1, },
+        // vertex d - left bottom
+        { -1 + scale_width() * x1, 1 - scale_height() * y2, w1, z1, },
+      }; 
+
+#if 0
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          std::cout << vertices[i][j] << ". ";
+        }
+        std::cout << std::endl;
+      }
+      std::cout << std::endl;
+#endif
+
+      {
+        auto read = iterator->framebuffer.read();
+        if (alt && iterator->alternative) {
+          read = iterator->alternative.read();
+        }
+
+        GLuint vertex_buffer = 0;
+        glGenBuffers(1, &vertex_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        {
+          auto shader = glProgram_.use();
+          shader.bind(glUniform1i, "texture", 0);
+          shader.bind(glEnableVertexAttribArray, "vpos");
+          shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
+          glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        }
+      }
+      y = y2;
+    }
+  }
+
+  const int64_t a = offset_y + y;
+  const int64_t b = offset_y + height;
+  for (auto iterator = container_.begin(); END != iterator; ++iterator) {
+    if (a < iterator->area.y + iterator->area.height && b > iterator->area.y) {
+      // from
+      const float w1 = 0;
+      float w2 = iterator->area.width;
+      w2 /= std::min(iterator->area.width, rectangle.width);
+      float z1 = 0;
+      float z2 = std::min(iterator->area.height, height_ - y);
+      z1 /= height_;
+      z2 /= height_;
+      assert(1 >= z2);
+      // to
+      const uint16_t x1 = iterator->area.x;
+      const uint16_t x2 = x1 + std::min(iterator->area.width, rectangle.width);
+      const uint16_t y1 = y;
+      uint16_t y2 = y1 + iterator->area.height;
+      if (height_ < y2) {
+        y2 = height_;
+      }
+      const float vertices[4][4] = {
+        // vertex a - left top
+        { -1 + scale_width() * x1, 1 - scale_height() * y1, w1, 1 - z1, },
+        // vertex b - right top
+        { -1 + scale_width() * x2, 1 - scale_height() * y1, w2, 1 - z1, },
+        // vertex c - right bottom
+        { -1 + scale_width() * x2, 1 - scale_height() * y2, w2, 1 - z2, },
+        // vertex d - left bottom
+        { -1 + scale_width() * x1, 1 - scale_height() * y2, w1, 1 - z2, },
+      }; 
+
+#if 0
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          std::cout << vertices[i][j] << "; ";
+        }
+        std::cout << std::endl;
+      }
+      std::cout << std::endl;
+#endif
+
+      {
+        auto read = iterator->framebuffer.read();
+        if (alt && iterator->alternative) {
+          read = iterator->alternative.read();
+        }
+
+        GLuint vertex_buffer = 0;
+        glGenBuffers(1, &vertex_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        {
+          auto shader = glProgram_.use();
+          shader.bind(glUniform1i, "texture", 0);
+          shader.bind(glEnableVertexAttribArray, "vpos");
+          shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
+          glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        }
+      }
+      y = y2;
+    }
+  }
+}
+
+bool Pages::paint(const uint16_t frame) {
+  if (container_.size() <= frame) {
+    return false;
+  }
+
+  auto iterator = container_.begin();
+  for (uint16_t counter = 0; frame > counter; ++counter) {
+    ++iterator;
+  }
+  assert(container_.end() != iterator);
+
+  const auto read = iterator->framebuffer.read();
+  const float vertices[4][4] = {
+    // vertex a - left top
+    { -1, 1, 0, 1, },
+    // vertex b - right top
+    { 1, 1, 1, 1, },
+    // vertex c - right bottom
+    { 1, -1, 1, 0, },
+    // vertex d - left bottom
+    { -1, -1, 0, 0, },
+  }; 
+
+  GLuint vertex_buffer = 0;
+  glGenBuffers(1, &vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+  {
+    auto shader = glProgram_.use();
+    shader.bind(glUniform1i, "texture", 0);
+    shader.bind(glEnableVertexAttribArray, "vpos");
+    shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  }
+
+  return true;
+}
+
+void Screen::backspace() {
+  assert(!"UNRECHEABLE");
+  const auto drawer = backend_->pages.draw(static_cast<Rectangle_Y>(dimensions_), 0);
+  drawer.clear(colors::black);
+#if 0
+  backend_->damage.emplace(Rectangle{
+    .x = drawer.target.x,
+    .y = overflow(),
+    .width = drawer.target.width,
+    .height = drawer.target.height,});
+#endif
+  repaint_ = PARTIAL;
+}
+
+void Screen::draw_erase_line_right() {
+  Rectangle_Y rectangle(dimensions_);
+  rectangle.width = dimensions_.surface_width() - rectangle.x;
+  const auto drawer = backend_->pages.draw(rectangle, 0);
+  drawer.clear(colors::black);
+#if 0
+  backend_->damage.emplace(Rectangle{
+    .x = drawer.target.x,
+    .y = overflow(),
+    .width = drawer.target.width,
+    .height = drawer.target.height,});
+#endif
+}
+
+/*
+ * scrolls lines top to bottom with a copy of the pages, only the lines it
+ * exposes are cleared, nothing is rasterized.
+ */
+void Screen::draw_scroll(const uint16_t top, const uint16_t bottom, const int n) {
+  const uint16_t count = std::min<int>(std::abs(n), bottom - top + 1);
+  const int32_t line_height = dimensions_.line_height();
+  const int64_t y = dimensions_.line_to_pixel(dimensions_.scrollback_lines() + top);
+  const int32_t height = (bottom - top + 1 - count) * line_height;
+  if (0 < height) {
+    Rectangle_Y source{
+      .x = 0,
+      .y = y,
+      .width = dimensions_.surface_width(),
+      .height = height, };
+    if (0 < n) {
+      source.y += count * line_height;
+      backend_->pages.move(source, 0, y);
+    } else {
+      backend_->pages.move(source, 0, y + count * line_height);
+    }
+  }
+  for (uint16_t i = 0; count > i; ++i) {
+    backend_->pages.blank(Rectangle_Y{
+        .x = 0,
+        .y = (0 < n ? y + height : y) + i * line_height,
+        .width = dimensions_.surface_width(),
+        .height = line_height, }, history_.size());
+  }
+}
+
+/*
+ * shifts the cursor line from column to its end n columns right, or left
+ * when negative, with a single copy, clearing the columns it vacates.
+ */
+void Screen::draw_shift(const uint16_t column, const int n) {
+  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
+  rectangle.x = dimensions_.column_to_pixel(column);
+  rectangle.width = dimensions_.surface_width() - rectangle.x;
+  const int32_t offset = std::min<int32_t>(std::abs(n) * dimensions_.glyph_width(), rectangle.width);
+  if (offset < rectangle.width) {
+    Rectangle_Y source = rectangle;
+    source.width -= offset;
+    if (0 < n) {
+      backend_->pages.move(source, rectangle.x + offset, rectangle.y);
+    } else {
+      source.x += offset;
+      backend_->pages.move(source, rectangle.x, rectangle.y);
+    }
+  }
+
+  Rectangle_Y vacated = rectangle;
+  vacated.width = offset;
+  if (0 > n) {
+    vacated.x += rectangle.width - offset;
+  }
+  backend_->pages.blank(vacated, history_.size());
+
+  backend_->damage.emplace(Rectangle{
+    .x = rectangle.x,
+    .y = overflow(),
+    .width = rectangle.width,
+    .height = rectangle.height, });
+}
+
+void Screen::draw_blank(const uint16_t column, const int n) {
+  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
+  rectangle.x = dimensions_.column_to_pixel(column);
+  rectangle.width = std::min<int32_t>(n * dimensions_.glyph_width(),
+      dimensions_.surface_width() - rectangle.x);
+  const Rectangle target = backend_->pages.blank(rectangle, history_.size());
+  backend_->damage.emplace(Rectangle{
+    .x = target.x,
+    .y = overflow(),
+    .width = target.width,
+    .height = target.height, });
+}
+
+void Screen::recreateFromScrollback(const uint64_t index, const int64_t bottom) {
+  if (0 == index) {
+    std::cerr << __FILE__ << ":" << __LINE__ << " " << __func__ << " index is less than or equal to 0." << std::endl;
+    return;
+  }
+  /* the page in front starts at index, this one takes up to a screen of rows before it */
+  const uint64_t end = std::min(index, history_.scrollback_size());
+  const auto [start, lines] = history_.rewind(end, dimensions_.lines());
+  if (0 == lines) {
+    return;
+  }
+  const int32_t page_size = lines * dimensions_.line_height();
+  Pages::Entry & page = backend_->pages.emplace_front(page_size, bottom);
+  page.index = start;
+  page.scrollback = true;
+  page.framebuffer.bind();
+  Rectangle target{
+    .x = 0,
+    .y = dimensions_.surface_height() - dimensions_.line_height(),
+    .width = dimensions_.glyph_width(),
+    .height = dimensions_.line_height(),
+  };
+  int16_t cursor_column = 1;
+  for (History::Iterator iterator = history_.iterator(page.index); end > iterator.index(); ++iterator) {
+    uint16_t columns = 1;
+    target.width = dimensions_.glyph_width();
+    rune::Rune rune = *iterator;
+    if (rune.iscontrol()) {
+      switch (rune.character) {
+      case L'\n': // new line
+        cursor_column = 1;
+        target.y -= dimensions_.line_height();
+        target.x = 0;
+        continue;
+      case L'\t': // horizontal tab
+        columns = 8 - (cursor_column % 8);
+        target.width *= columns;
+        rune.character = L' ';
+        break;
+      default:
+        std::cerr << static_cast<int>(rune.character) << std::endl;
+        assert(!"UNIMPLEMENTED");
+        break;
+      }
+    }
+    const bool wrap = dimensions_.columns() < cursor_column;
+    if (wrap) {
+      cursor_column = 1;
+      target.y -= dimensions_.line_height();
+      target.x = 0;
+    }
+#if 1
+    glEnable(GL_SCISSOR_TEST);
+    target(glScissor);
+    rune.background()(glClearColor);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+#endif
+    renderCharacter(target, rune);
+    target.x += target.width;
+    cursor_column += columns;
+  }
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Screen::draw_active_history() {
+  const int32_t pageSize = dimensions_.lines() * dimensions_.line_height();
+  Pages::Entry & page = backend_->pages.emplace_front(pageSize);
+  page.index = history_.scrollback_size();
+  page.framebuffer.bind();
+  Rectangle target{
+    .x = 0,
+    .y = dimensions_.surface_height() - dimensions_.line_height(),
+    .width = dimensions_.glyph_width(),
+    .height = dimensions_.line_height(),
+  };
+  const uint16_t columns = history_.columns();
+  uint16_t column = 1, last_column = 1, last_line = 1, stride = 1;
+  for (uint16_t i = 1; dimensions_.lines() >= i; ++i) {
+    for (uint16_t j = 1; columns > j; ++j) {
+      target.width = dimensions_.glyph_width();
+      const uint32_t index = (i - 1) * columns + j;
+      rune::Rune rune = history_.at(index);
+      if (rune.iscontrol()) {
+        switch (rune.character) {
+        case L'\n':
+          break;
+
+        case L'\0':
+          break;
+
+        case L'\t': // horizontal tab
+          stride = 8 - (column % 8);
+          if (columns < column + stride) {
+            stride = columns - column;
+          }
+          target.width *= stride;
+          rune.character = L' ';
+          break;
+
+        default:
+          std::cerr << static_cast<int>(rune.character) << std::endl;
+          assert(!"UNIMPLEMENTED");
+          break;
+        }
+      }
+      if (static_cast<bool>(rune.character)) {
+        if (i >= last_line) {
+          last_line = i;
+          last_column = j + stride;
+        }
+#if 1
+        glEnable(GL_SCISSOR_TEST);
+        target(glScissor);
+        rune.background()(glClearColor);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+#endif
+        renderCharacter(target, rune);
+      }
+      target.x += target.width;
+      column += stride;
+    }
+    column = 1;
+    target.y -= dimensions_.line_height();
+    target.x = 0;
+  }
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // assert(0 <= target.y);
+  // assert(dimensions_.lines() >= lines);
+  // assert(dimensions_.surface_width() >= target.x);
+}
+
+Pages::Entry & Pages::emplace_front(const int32_t height) {
+  return emplace_front(height, container_.empty() ? height : front_y());
+}
+
+Pages::Entry & Pages::emplace_front(const int32_t height, const int64_t bottom) {
+  assert(0 < height);
+  assert(0 < height_);
+  assert(height <= height_);
+  assert(container_.empty() || front_y() >= bottom);
+
+  const Rectangle_Y rectangle{
+    .x = 0,
+    .y = bottom - height,
+    .width = width_,
+    .height = height,
+  };
+
+  Pages::Entry & page = container_.emplace_front(new_entry(rectangle, 0));
+
+  if (1 == container_.size()) {
+    current_ = container_.begin();
+  }
+
+  return page;
+}
+
+Pages::Entry Pages::new_entry(const Rectangle_Y & rectangle, const uint64_t index) {
+  assert(0 < width_);
+  assert(0 < height_);
+#if 0
+  const Color color{
+    .red = static_cast<float>(drand48()),
+    .green = static_cast<float>(drand48()),
+    .blue = static_cast<float>(drand48()),
+    .alpha = 1.f, };
+#else
+  const Color color = colors::black;
+#endif
+  return Entry{
+    .framebuffer = opengl::Framebuffer::New(width_, height_, color),
+    .area{
+      .x = 0,
+      .y = rectangle.y,
+      .width = width_, /* currently unused */
+      .height = rectangle.height,
+    },
+    .index = index,
+    };
+}
+
+void Pages::drop_scrollback() {
+  drop_scrollback(0, 0);
+}
+
+void Pages::drop_scrollback(const int64_t top, const int64_t bottom) {
+  for (auto iterator = container_.begin(); container_.end() != iterator && iterator->scrollback; ) {
+    if (top < bottom && iterator->area.y < bottom && iterator->area.y + iterator->area.height > top) {
+      ++iterator;
+      continue;
+    }
+    if (current_ == iterator) {
+      current_ = container_.end();
+    }
+    iterator = container_.erase(iterator);
+  }
+}
+
+int64_t Pages::live_y() const {
+  const auto iterator = std::find_if(container_.begin(), container_.end(), [](const Entry & entry) { return ! entry.scrollback; });
+  return container_.end() == iterator ? scrollback_y() : iterator->area.y;
+}
+
+int64_t Pages::scrollback_y() const {
+  int64_t y = front_y();
+  for (auto iterator = container_.begin(); container_.end() != iterator && iterator->scrollback; ++iterator) {
+    y = iterator->area.y + iterator->area.height;
+  }
+  return y;
+}
+
+bool Pages::has_alternative() const {
+  bool result = false;
+  for (const auto & entry : container_) {
+    result |= entry.alternative;
+    if (result) {
+      break;
+    }
+  }
+  return result;
+}
+
+void Screen::draw_cursor(const int32_t offset) const {
+  Rectangle target{static_cast<Rectangle>(dimensions_)};
+  target.y = offset;
+  glEnable(GL_SCISSOR_TEST);
+  target(glScissor);
+  colors::white(glClearColor);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glDisable(GL_SCISSOR_TEST);
+}
+
+/* over the pages as they are, nothing is drawn into them */
+void Screen::draw_matches(const int64_t offset_y) const {
+  glEnable(GL_SCISSOR_TEST);
+  for (const auto & [rectangle, current] : highlights(offset_y)) {
+    rectangle(glScissor);
+    (current ? colors::white : colors::yellow)(glClearColor);
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+  glDisable(GL_SCISSOR_TEST);
+}
+
+void Damage::emplace(Rectangle && r) {
+  if (container_.empty()) {
+    container_.emplace(std::move(r));
+    return;
+  }
+#if 1 // turn optimization on/off
+  auto iterator = container_.lower_bound(r);
+  if (container_.end() == iterator) {
+    --iterator;
+  }
+  if (iterator->overlaps(r)) {
+    if (iterator->contains(r)) {
+      return;
+    }
+    const bool incorporated = r.incorporate(*iterator);
+    if (incorporated) {
+      container_.erase(iterator);
+    }
+  }
+#endif
+  container_.emplace(std::move(r));
+}
+
+uint32_t Damage::area() const {
+  uint32_t area = 0;
+  for (const auto & item : container_) {
+    area += item.area();
+  }
+  return area;
+}
+
+void Screen::new_line() {
+  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
+  backend_->pages.draw(rectangle, history_.size());
+}
\ No newline at end of file
@@ -5,8 +5,7 @@
 #include <thread>
 
 #include <cassert>
-
-#include <GL/gl.h>
+#include <cstdlib>
 
 #include "screen.h"
 #include "types.h"
@@ -31,207 +30,82 @@ std::ostream & operator << (std::ostream & o, const Screen::Repaint r) {
 }
 } // end of annonymous namespace
 
-Screen Screen::New(const wayland::Connection & connection) {
-  auto egl = connection.egl();
-  std::unique_ptr<wayland::Surface> surface = connection.surface(std::move(egl));
-
-  surface->setTitle("Moonshot");
-
-  Screen screen(std::move(surface));
-
-  screen.makeCurrent();
-  screen.swapBuffers();
-
-  connection.roundtrip();
-
-  screen.glProgram_.vertex(
-      "#version 120\n"
-      "attribute vec4 vpos;\n"
-      "varying vec2 texcoord;\n"
-      "void main()\n"
-      "{\n"
-      "    texcoord = vpos.zw;\n"
-      "    gl_Position = vec4(vpos.xy, 0, 1);\n"
-      "}\n")
-    .fragment(
-      "#version 120\n"
-      "uniform sampler2D texture;\n"
-      "uniform vec3 background;\n"
-      "uniform vec3 color;\n"
-      "varying vec2 texcoord;\n"
-      "void main()\n"
-      "{\n"
-      "    vec3 character = texture2D(texture, texcoord).rgb;\n"
-      "    gl_FragColor = vec4(mix(background, color, character), 1.0);\n"
-      "}\n")
-    .link();
-
-  screen.pages_.glProgram_.vertex(
-      "#version 120\n"
-      "attribute vec4 vpos;\n"
-      "varying vec2 texcoord;\n"
-      "void main()\n"
-      "{\n"
-      "    texcoord = vpos.zw;\n"
-      "    gl_Position = vec4(vpos.xy, 0, 1);\n"
-      "}\n")
-    .fragment(
-      "#version 120\n"
-      "uniform sampler2D texture;\n"
-      "varying vec2 texcoord;\n"
-      "void main()\n"
-      "{\n"
-      "    gl_FragColor = texture2D(texture, texcoord);\n"
-      "}\n")
-    .link();
-
-  return screen;
-}
-
-void Screen::setTitle(const std::string & title) {
-  assert(surface_);
-  if ( ! title.empty()) {
-    surface_->setTitle(title);
-  } else {
-    std::cerr << __FILE__ << ":" << __LINE__ << " " << __func__ << " empty title is not supported." << std::endl;
-  }
-}
-
-Screen::Screen(std::unique_ptr<wayland::Surface> && surface) : surface_(std::move(surface)) {
-  assert(static_cast<bool>(surface_));
-  surface_->onResize = std::bind_front(&Screen::resize, this);
+std::ostream & operator << (std::ostream & o, const Screen::Jumps & j) {
+  o << j.frames << " frames jumped, " << j.skipped << " screens skipped";
+  return o;
 }
 
 void Screen::resize(const uint16_t width, const uint16_t height) {
   assert(0 < width);
   assert(0 < height);
 
-  /**
-   * Pages::reset currently breaks if height
-   * is anything different than surface_height
-   */
-  pages_.reset(width, height);
-
-  { /* dimensions */
-    freetype::Face & face = characters_.font().regular();
-    dimensions_.reset(face, width, height);
-  }
+  reset(width, height);
 
   { /* history */
     history_.resize(dimensions_.columns(), dimensions_.lines());
+    if (dimensions_.has_margins() && lines() < dimensions_.bottom_margin()) {
+      dimensions_.margins(0, 0);
+    }
+    if (dimensions_.has_margins()) {
+      history_.margins(dimensions_.top_margin(), dimensions_.bottom_margin());
+    }
   }
 
-  if (0 < history_.active_size()) {
-    resetScroll();
-    recreateFromActiveHistory();
-  } else {
-    opengl::clear(dimensions_.surface_width(), dimensions_.surface_height(), colors::black);
-    swapBuffers();
-  }
+  redraw();
 
   if (static_cast<bool>(onResize)) {
     onResize(width, height);
   }
 }
 
-Screen::Screen(Screen && other) : surface_(std::move(other.surface_)) { }
-
-void Screen::changeScrollY(int32_t value) {
-  value *= -2;
-  const uint64_t new_value = dimensions_.scroll_y() + value;
-  if (0 < value) /* if we are scrolling up */  {
-    if (new_value + dimensions_.surface_height() >= pages_.total_height()) {
-      const uint64_t index = pages_.front_index();
-      if (1 < index) {
-        recreateFromScrollback(index - 1);
-      }
-    }
-  }
-  if (0 < value || dimensions_.scroll_y() > value * -1) {
-    dimensions_.scroll_y(new_value);
-    repaint_ = FULL;
-  } else if (0 < dimensions_.scroll_y()) {
-    dimensions_.scroll_y(0);
+void Screen::redraw() {
+  if (0 < history_.active_size()) {
+    resetScroll();
+    recreateFromActiveHistory();
+  } else if (withheld()) {
     repaint_ = FULL;
+  } else {
+    clear();
   }
 }
 
-void Screen::renderCharacter(const Rectangle & target, const rune::Rune & rune) {
-  const Character & character = characters_.retrieve(rune);
-  const float vertex_bottom = pages_.scale_height() * (target.y + character.top - (dimensions_.glyph_descender() + character.height));
-  const float vertex_left = pages_.scale_width() * (target.x + character.left);
-  const float vertex_right = pages_.scale_width() * (target.x + character.left + character.width);
-  const float vertex_top = pages_.scale_height() * (target.y + character.top - dimensions_.glyph_descender());
-
-  const float vertices[4][4] = {
-    // vertex a - left top
-    { -1.f + vertex_left, -1.f + vertex_top, 0, 0, },
-    // vertex b - right top
-    { -1.f + vertex_right, -1.f + vertex_top, 1, 0, },
-    // vertex c - right bottom
-    { -1.f + vertex_right, -1.f + vertex_bottom, 1, 1, },
-    // vertex d - left bottom
-    { -1.f + vertex_left, -1.f + vertex_bottom, 0, 1, },}; 
-
-  GLuint vertex_buffer = 0;
-  glGenBuffers(1, &vertex_buffer);
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-  assert(0 != character.texture);
-  glBindTexture(GL_TEXTURE_2D, character.texture);
-  glActiveTexture(GL_TEXTURE0 + character.texture);
-
-  {
-    auto shader = glProgram_.use();
-    shader.bind(glUniform1i, "texture", 0);
-    shader.bind(glUniform3fv, "background", 1, rune.backgroundColor);
-    shader.bind(glUniform3fv, "color", 1, rune.foregroundColor);
-    shader.bind(glEnableVertexAttribArray, "vpos");
-    shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+/*
+ * prints a run of printable runes, wrapping, drawing, damaging and storing
+ * them once per row segment.
+ */
+void Screen::print(std::span<const rune::Rune> runes) {
+  if (runes.empty()) {
+    return;
   }
 
-  glDeleteBuffers(1, &vertex_buffer);
-  glActiveTexture(GL_TEXTURE0);
-
-  if (rune.crossout) {
-    const Rectangle crossout {
-      .x = target.x,
-      .y = target.y + dimensions_.line_height() / 2,
-      .width = target.width,
-      .height = 1,
-    };
-    glEnable(GL_SCISSOR_TEST);
-    crossout(glScissor);
-    rune.foregroundColor(glClearColor);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_SCISSOR_TEST);
+  if (FULL != repaint_ && 0 < dimensions_.scroll_y()) {
+    resetScroll();
+    repaint_ = FULL;
+  } else if (NO == repaint_) {
+    repaint_ = PARTIAL;
   }
 
-  if (rune.underline) {
-    const Rectangle underline {
-      .x = target.x,
-      .y = target.y + 2,
-      .width = target.width,
-      .height = 1,
-    };
-    glEnable(GL_SCISSOR_TEST);
-    underline(glScissor);
-    rune.foregroundColor(glClearColor);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_SCISSOR_TEST);
-  }
-}
+  while ( ! runes.empty()) {
+    if (dimensions_.wrap_next()) {
+      line_feed();
+      dimensions_.cursor_column(1);
+    }
 
-void Screen::pushBack(rune::Rune && rune) {
-  if (dimensions_.wrap_next()) {
-    if (dimensions_.new_line()) {
-      repaint_ = FULL;
+    assert(columns() >= column());
+    const std::span<const rune::Rune> segment = runes.first(
+        std::min<std::size_t>(runes.size(), columns() - column() + 1));
+
+    if ( ! jumping_) {
+      pushCharacters(segment);
     }
-    dimensions_.cursor_column(1);
+    dimensions_.cursor_column(column() + segment.size());
+
+    history_.emplace_run(segment);
+    runes = runes.subspan(segment.size());
   }
+}
 
+void Screen::pushBack(rune::Rune && rune) {
   if (FULL != repaint_ && 0 < dimensions_.scroll_y()) {
     resetScroll();
     repaint_ = FULL;
@@ -248,8 +122,7 @@ void Screen::pushBack(rune::Rune && rune) {
     return;
 
   case L'\b': // backspace
-    dimensions_.cursor_column(column() - 1);
-    history_.move_cursor_backward(1);
+    move_cursor_backward(1);
     return;
 
   case L'\r': // carriage return
@@ -258,122 +131,160 @@ void Screen::pushBack(rune::Rune && rune) {
     return;
 
   case L'\n': // new line
-    new_line();
-    if (dimensions_.new_line()) {
-      repaint_ = FULL;
+    if ( ! jumping_ && ! dimensions_.has_margins()) {
+      new_line();
     }
+    line_feed();
     history_.new_line();
     return;
   }
 
-  if ( ! long_transaction_) {
+  /* controls act on a pending wrap, only printing takes it */
+  if (dimensions_.wrap_next()) {
+    line_feed();
+    dimensions_.cursor_column(1);
+  }
+
+  if ( ! jumping_) {
     const uint16_t columns = pushCharacter(rune);
     dimensions_.cursor_column(column() + columns);
+  } else {
+    dimensions_.cursor_column(column() + (L'\t' == rune.character ? 8 - (column() % 8) : 1));
   }
 
   history_.emplace(std::move(rune));
 }
 
-uint16_t Screen::pushCharacter(rune::Rune rune) {
-  assert(0 < dimensions_.glyph_width());
-  uint16_t columns = 1; 
-  switch (rune.character) {
-  case L'\0':
-    rune.character = L' ';
-    break;
-
-  case L'\t': // horizontal tab
-    columns = 8 - (column() % 8);
-    rune.character = L' ';
-    break;
-
-  default:
-    break;
-  }
-
-  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
-  rectangle.width = dimensions_.glyph_width() * columns;
-
-  {
-    const auto drawer = pages_.draw(rectangle, history_.size());
-    drawer.clear(rune.backgroundColor);
-    renderCharacter(drawer.target, rune);
-
-    if (rune::Blink::STEADY != rune.blink) {
-      drawer.create_alternative();
-      rune.foregroundColor = rune.backgroundColor;
-    }
+//TODO: make sure there is no parallel execution here.
+/*
+ * synchronized updates (dec mode 2026), while one is open the pages keep
+ * being drawn but nothing is presented, damage accumulates until the update
+ * ends and is swapped at once. applications which never end it are given up
+ * on after SYNCHRONIZED_TIMEOUT.
+ */
+namespace {
+constexpr std::chrono::milliseconds SYNCHRONIZED_TIMEOUT{150};
+} // end of annonymous namespace
 
-    if (drawer.alternative()) {
-      drawer.clear(rune.backgroundColor);
-      renderCharacter(drawer.target, rune);
+void Screen::synchronize(const bool mode) {
+  if (mode) {
+    synchronized_ = std::chrono::steady_clock::now();
+  } else if (synchronized_.has_value()) {
+    synchronized_.reset();
+    if (NO == repaint_) {
+      repaint_ = PARTIAL;
     }
-
-    Rectangle r{
-      .x = drawer.target.x,
-      .y = overflow(),
-      .width = drawer.target.width,
-      .height = drawer.target.height, };
-
-    damage_.emplace(std::move(r));
   }
+}
 
-  return columns;
+bool Screen::withheld() {
+  if ( ! synchronized_.has_value()) {
+    return false;
+  }
+  if (SYNCHRONIZED_TIMEOUT > std::chrono::steady_clock::now() - synchronized_.value()) {
+    return true;
+  }
+  synchronized_.reset();
+  repaint_ = FULL;
+  return false;
 }
 
-//TODO: make sure there is no parallel execution here.
 void Screen::repaint(const bool force, const bool alternative) {
   assert(0 < dimensions_.surface_height());
   assert(0 < dimensions_.surface_width());
 
+  if (withheld()) {
+    return;
+  }
+
+  if (jumping_) {
+    land();
+  }
+  scrolled_ = 0;
+  drain();
+
   if (force || NO != repaint_) {
-    opengl::clear(dimensions_.surface_width(), dimensions_.surface_height(), colors::black);
-#if 1
-    int32_t height = static_cast<int32_t>(dimensions_.line_to_pixel(dimensions_.displayed_lines() + 1));
-    int64_t offset_y = 0;
-    if (0 < dimensions_.scrollback_lines()) {
-      offset_y = dimensions_.scrollback_lines() * dimensions_.line_height();
-    }
+    present(force, alternative);
+  }
+  repaint_ = NO;
+}
 
-    if (0 != dimensions_.scroll_y()) {
-      offset_y -= dimensions_.scroll_y();
-      height = dimensions_.surface_height();
-    } else if (dimensions_.overflow()) {
-      offset_y -= dimensions_.remainder();
+/*
+ * moves the cursor a line down for a line feed or a wrap, scrolling either
+ * the screen or the region when at its bottom, history follows on its own.
+ */
+void Screen::line_feed() {
+  if ( ! dimensions_.has_margins()) {
+    if (dimensions_.new_line()) {
+      scrolled();
     }
+    return;
+  }
 
-    pages_.repaint(
-      Rectangle{
-        .x = 0,
-        .y = 0,
-        .width = dimensions_.surface_width(),
-        .height = height, },
-      offset_y,
-      alternative);
-#else
-    pages_.paint(0);
-#endif
-
-    if (alternative && 0 == dimensions_.scroll_y()) {
-      draw_cursor(overflow());
+  const uint16_t line = Screen::line();
+  if (dimensions_.bottom_margin() == line) {
+    if ( ! jumping_) {
+      draw_scroll(dimensions_.top_margin(), dimensions_.bottom_margin(), 1);
     }
+    scrolled();
+  } else if (lines() > line) {
+    /* below the region nothing scrolls */
+    dimensions_.cursor_line(line + 1);
+  }
+}
 
-    const bool forceSwapBuffers = force || damage_.empty() || FULL == repaint_;
-    swapBuffers(forceSwapBuffers);
+void Screen::scroll(const int n) {
+  assert(0 != n);
+  const uint16_t top = dimensions_.top_margin(),
+        bottom = dimensions_.bottom_margin();
+  history_.scroll(top, bottom, n);
+  if ( ! jumping_) {
+    draw_scroll(top, bottom, n);
   }
-  repaint_ = NO;
+  scrolled();
 }
 
-void Screen::swapBuffers(bool fullSwap) {
-  fullSwap |= damage_.area() * 2 >= dimensions_.area();
-  if ( ! fullSwap && ! damage_.empty()) {
-    std::vector<Rectangle> rectangles;
-    damage_.transfer(rectangles);
-    surface_->egl().swapBuffers(rectangles);
+void Screen::margins(const uint16_t top, const uint16_t bottom) {
+  assert(0 < top);
+  assert(top < bottom);
+  assert(lines() >= bottom);
+  if (1 == top && lines() == bottom) {
+    dimensions_.margins(0, 0);
+    history_.margins(0, 0);
   } else {
-    surface_->egl().swapBuffers();
+    dimensions_.margins(top, bottom);
+    history_.margins(top, bottom);
+  }
+  move_cursor(1, 1);
+}
+
+void Screen::scrolled() {
+  repaint_ = FULL;
+  ++scrolled_;
+  if ( ! jumping_ && 0 < jump_scroll_.screens
+      && static_cast<uint32_t>(jump_scroll_.screens) * lines() <= scrolled_) {
+    jumping_ = true;
+    calm_ = 0;
+  }
+}
+
+/*
+ * ends a jumped frame, rasterizing the grid as history holds it, jump
+ * scrolling stops after enough frames scrolling less than the threshold.
+ */
+void Screen::land() {
+  assert(jumping_);
+  ++jumps_.frames;
+  jumps_.skipped += scrolled_ / lines();
+
+  if (static_cast<uint32_t>(jump_scroll_.screens) * lines() <= scrolled_) {
+    calm_ = 0;
+  } else if (jump_scroll_.frames <= ++calm_) {
+    jumping_ = false;
   }
-  damage_.clear();
+
+  reset(dimensions_.surface_width(), dimensions_.surface_height());
+  redraw();
 }
 
 void Screen::move_cursor(const int column, const int line) {
@@ -389,402 +300,94 @@ void Screen::reverse_line_feed() {
   const uint16_t line = Screen::line();
   assert(0 < line);
   assert(lines() >= line);
-  if (1 == line) {
-    history_.reverse_line_feed();
-    resize(dimensions_.surface_width(), dimensions_.surface_height());
-  } else {
-    history_.move_cursor(column(), line - 1);
+  if (dimensions_.top_margin() == line) {
+    scroll(-1);
+  } else if (1 < line) {
+    move_cursor(std::min<int32_t>(column(), columns()), line - 1);
   }
 }
 
-Pages::Drawer::~Drawer() {
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-  glBindTexture(GL_TEXTURE_2D, 0);
-}
-
-Pages::Drawer::Drawer(const Pages & p, Entry & e, Rectangle && r) : pages_(p), entry_(e), target(std::move(r)) {
-  entry_.framebuffer.bind();
-}
-
-bool Pages::Drawer::alternative() const {
-  const bool result = entry_.alternative;
-  if (result) {
-    entry_.alternative.bind();
-  }
-  return result;
-}
-
-void Pages::Drawer::create_alternative() const {
-  if ( ! entry_.alternative) {
-    entry_.alternative = entry_.framebuffer.clone(pages_.width_, pages_.height_);
+/*
+ * DCH, ICH and ECH shift or blank the rest of the line in place, the pixels
+ * already drawn are moved rather than rasterized again.
+ */
+void Screen::erase(const int n) {
+  assert(0 < n);
+  history_.erase(n);
+  if ( ! jumping_) {
+    draw_shift(std::min<int32_t>(column(), columns()), -n);
   }
-}
-
-uint32_t Pages::total_height() const {
-  uint32_t result = 0;
-  for (const auto & item : container_) {
-    result += item.area.height;
+  if (NO == repaint_) {
+    repaint_ = PARTIAL;
   }
-  return result;
-}
-
-void Pages::Drawer::clear(const Color & color) const {
-  glEnable(GL_SCISSOR_TEST);
-  target(glScissor);
-  color(glClearColor);
-  glClear(GL_COLOR_BUFFER_BIT);
-  glDisable(GL_SCISSOR_TEST);
 }
 
-Pages::Drawer Pages::draw(Rectangle_Y rectangle, const uint64_t index) {
-  assert(height_ >= rectangle.height);
-  assert(width_ >= rectangle.width);
-  Entry & entry = update(rectangle, index);
-  return Drawer(*this, entry, static_cast<Rectangle>(rectangle));
-}
-
-void Pages::reset(const uint16_t width, const uint16_t height) {
-  width_ = width;
-  height_ = height;
-  container_.clear();
-  current_ = container_.end();
-}
-
-Pages::Entry & Pages::update(Rectangle_Y & rectangle, const uint64_t index) {
-  bool found = false;
-
-  // cache hit, skip a look-up
-  if (container_.end() != current_ && current_->area.y <= rectangle.y && current_->area.y + height_ >= rectangle.y + rectangle.height) {
-    // grow current page area height.
-    const uint64_t new_height = rectangle.y + rectangle.height - current_->area.y;
-    if (current_->area.height < new_height) {
-      current_->area.height = new_height;
-    }
-    found = true;
-
-  // cache miss
-  } else if ( ! container_.empty()) {
-    const Container::const_iterator END = container_.end();
-    Container::iterator iterator = container_.begin();
-    assert(iterator->area.y <= rectangle.y);
-    for (; END != iterator; ++iterator) {
-      if (iterator->area.y <= rectangle.y && iterator->area.y + iterator->area.height > rectangle.y) {
-        // can't grow a previously full buffer
-        assert(iterator->area.y + height_ >= rectangle.y + rectangle.height);
-        current_ = iterator;
-        const uint64_t new_height = rectangle.y + rectangle.height - current_->area.y;
-        if (current_->area.height < new_height) {
-          current_->area.height = new_height;
-        }
-        found = true;
-        break;
-      }
-    }
+void Screen::insert(const int n) {
+  assert(0 < n);
+  history_.insert(n);
+  if ( ! jumping_) {
+    draw_shift(std::min<int32_t>(column(), columns()), n);
   }
-
-  if ( ! found) { 
-    // cap it to the last cap_ pages.
-    if (0 < cap_ && container_.size() >= cap_) {
-      const auto begin = container_.begin();
-      auto end = begin;
-      for (int i = 0; i <= container_.size() - cap_; ++i) {
-        assert(container_.end() != end);
-        ++end;
-      }
-      container_.erase(begin, end);
-    }
-
-    // if it did not find a page, insert a new page at the end.
-    current_ = container_.emplace(container_.end(), new_entry(rectangle, index));
+  if (NO == repaint_) {
+    repaint_ = PARTIAL;
   }
-  rectangle.y = height_ - (rectangle.y - current_->area.y) - rectangle.height;
-
-  assert(container_.end() != current_);
-  return *current_;
 }
 
-void Pages::repaint(const Rectangle rectangle, const int64_t offset_y, const bool alt) {
-  assert(0 == rectangle.x);
-  assert(width_ >= rectangle.width);
-  const auto END = container_.end();
-  uint16_t y = 0, height = 0;
-  for (auto iterator = container_.begin(); END != iterator; ++iterator) {
-    height += iterator->area.height;
-    if (rectangle.height < height) {
-      height = rectangle.height;
-      break;
-    }
-  }
-
-  if (0 == height) {
-    return;
-  } else if (height_ < height) {
-    height = height_;
-  }
-
-  for (auto iterator = container_.begin(); END != iterator; ++iterator) {
-    if (offset_y > iterator->area.y && offset_y <= iterator->area.y + iterator->area.height) {
-      // from
-      const float w1 = 0;
-      float w2 = iterator->area.width;
-      w2 /= std::min(iterator->area.width, rectangle.width);
-      float z1 = height_ - iterator->area.height;
-      float z2 = z1 + iterator->area.height - (offset_y - iterator->area.y);
-      z1 /= height_;
-      z2 /= height_;
-      // to
-      const uint16_t x1 = iterator->area.x;
-      const uint16_t x2 = x1 + std::min(iterator->area.width, rectangle.width);
-      const uint16_t y1 = y;
-      uint16_t y2 = y1 + iterator->area.height - (offset_y - iterator->area.y);
-      const float vertices[4][4] = {
-        // vertex a - left top
-        { -1 + scale_width() * x1, 1 - scale_height() * y1, w1, z2, },
-        // vertex b - right top
-        { -1 + scale_width() * x2, 1 - scale_height() * y1, w2, z2, },
-        // vertex c - right bottom
-        { -1 + scale_width() * x2, 1 - scale_height() * y2, w2, z1, },
-        // vertex d - left bottom
-        { -1 + scale_width() * x1, 1 - scale_height() * y2, w1, z1, },
-      }; 
-
-#if 0
-      for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-          std::cout << vertices[i][j] << ". ";
-        }
-        std::cout << std::endl;
-      }
-      std::cout << std::endl;
-#endif
-
-      {
-        auto read = iterator->framebuffer.read();
-        if (alt && iterator->alternative) {
-          read = iterator->alternative.read();
-        }
-
-        GLuint vertex_buffer = 0;
-        glGenBuffers(1, &vertex_buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-        {
-          auto shader = glProgram_.use();
-          shader.bind(glUniform1i, "texture", 0);
-          shader.bind(glEnableVertexAttribArray, "vpos");
-          shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
-          glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-        }
-      }
-      y = y2;
-    }
+void Screen::erase_characters(const int n) {
+  assert(0 < n);
+  history_.erase_characters(n);
+  if ( ! jumping_) {
+    draw_blank(std::min<int32_t>(column(), columns()), n);
   }
-
-  const int64_t a = offset_y + y;
-  const int64_t b = offset_y + height;
-  for (auto iterator = container_.begin(); END != iterator; ++iterator) {
-    if (a < iterator->area.y + iterator->area.height && b > iterator->area.y) {
-      // from
-      const float w1 = 0;
-      float w2 = iterator->area.width;
-      w2 /= std::min(iterator->area.width, rectangle.width);
-      float z1 = 0;
-      float z2 = std::min(iterator->area.height, height_ - y);
-      z1 /= height_;
-      z2 /= height_;
-      assert(1 >= z2);
-      // to
-      const uint16_t x1 = iterator->area.x;
-      const uint16_t x2 = x1 + std::min(iterator->area.width, rectangle.width);
-      const uint16_t y1 = y;
-      uint16_t y2 = y1 + iterator->area.height;
-      if (height_ < y2) {
-        y2 = height_;
-      }
-      const float vertices[4][4] = {
-        // vertex a - left top
-        { -1 + scale_width() * x1, 1 - scale_height() * y1, w1, 1 - z1, },
-        // vertex b - right top
-        { -1 + scale_width() * x2, 1 - scale_height() * y1, w2, 1 - z1, },
-        // vertex c - right bottom
-        { -1 + scale_width() * x2, 1 - scale_height() * y2, w2, 1 - z2, },
-        // vertex d - left bottom
-        { -1 + scale_width() * x1, 1 - scale_height() * y2, w1, 1 - z2, },
-      }; 
-
-#if 0
-      for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-          std::cout << vertices[i][j] << "; ";
-        }
-        std::cout << std::endl;
-      }
-      std::cout << std::endl;
-#endif
-
-      {
-        auto read = iterator->framebuffer.read();
-        if (alt && iterator->alternative) {
-          read = iterator->alternative.read();
-        }
-
-        GLuint vertex_buffer = 0;
-        glGenBuffers(1, &vertex_buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-        {
-          auto shader = glProgram_.use();
-          shader.bind(glUniform1i, "texture", 0);
-          shader.bind(glEnableVertexAttribArray, "vpos");
-          shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
-          glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-        }
-      }
-      y = y2;
-    }
+  if (NO == repaint_) {
+    repaint_ = PARTIAL;
   }
 }
 
-bool Pages::paint(const uint16_t frame) {
-  if (container_.size() <= frame) {
-    return false;
-  }
-
-  auto iterator = container_.begin();
-  for (uint16_t counter = 0; frame > counter; ++counter) {
-    ++iterator;
+/* IL and DL scroll the region from the cursor down, outside of it they do nothing */
+void Screen::insert_lines(const int n) {
+  assert(0 < n);
+  const uint16_t line = Screen::line();
+  if (dimensions_.top_margin() > line || dimensions_.bottom_margin() < line) {
+    return;
   }
-  assert(container_.end() != iterator);
-
-  const auto read = iterator->framebuffer.read();
-  const float vertices[4][4] = {
-    // vertex a - left top
-    { -1, 1, 0, 1, },
-    // vertex b - right top
-    { 1, 1, 1, 1, },
-    // vertex c - right bottom
-    { 1, -1, 1, 0, },
-    // vertex d - left bottom
-    { -1, -1, 0, 0, },
-  }; 
-
-  GLuint vertex_buffer = 0;
-  glGenBuffers(1, &vertex_buffer);
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-  {
-    auto shader = glProgram_.use();
-    shader.bind(glUniform1i, "texture", 0);
-    shader.bind(glEnableVertexAttribArray, "vpos");
-    shader.bind(glVertexAttribPointer, "vpos", 4, GL_FLOAT, GL_FALSE, sizeof(vertices[0]), nullptr);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  history_.scroll(line, dimensions_.bottom_margin(), -n);
+  if ( ! jumping_) {
+    draw_scroll(line, dimensions_.bottom_margin(), -n);
   }
-
-  return true;
-}
-
-void Screen::backspace() {
-  assert(!"UNRECHEABLE");
-  const auto drawer = pages_.draw(static_cast<Rectangle_Y>(dimensions_), 0);
-  drawer.clear(colors::black);
-#if 0
-  damage_.emplace(Rectangle{
-    .x = drawer.target.x,
-    .y = overflow(),
-    .width = drawer.target.width,
-    .height = drawer.target.height,});
-#endif
-  repaint_ = PARTIAL;
-}
-
-void Screen::erase_line_right() {
-  history_.erase_line_right();
-  Rectangle_Y rectangle(dimensions_);
-  rectangle.width = dimensions_.surface_width() - rectangle.x;
-  const auto drawer = pages_.draw(rectangle, 0);
-  drawer.clear(colors::black);
-#if 0
-  damage_.emplace(Rectangle{
-    .x = drawer.target.x,
-    .y = overflow(),
-    .width = drawer.target.width,
-    .height = drawer.target.height,});
-#endif
-  repaint_ = PARTIAL;
+  move_cursor(1, line);
+  repaint_ = FULL;
 }
 
-void Screen::erase(const int n) {
+void Screen::delete_lines(const int n) {
   assert(0 < n);
-  int32_t width = 0;
-  history_.erase(n);
-  const uint16_t column = Screen::column(),
-        end = dimensions_.columns(),
-        difference = end - column;
-  for (int i = 0; difference >= i; ++i) {
-    const rune::Rune & rune = history_.at(column + i, line());
-    const uint16_t columns = pushCharacter(rune);
-    dimensions_.cursor_column(dimensions_.cursor_column() + columns);
+  const uint16_t line = Screen::line();
+  if (dimensions_.top_margin() > line || dimensions_.bottom_margin() < line) {
+    return;
   }
-  dimensions_.cursor_column(column);
-  repaint_ = PARTIAL;
-}
-
-void Screen::insert(const int n) {
-  assert(0 < n);
-  int32_t width = 0;
-  history_.insert(n);
-  const uint16_t column = Screen::column(),
-        end = dimensions_.columns(),
-        difference = end - column;
-  for (int i = 0; difference >= i; ++i) {
-    const rune::Rune & rune = history_.at(column + i, line());
-    const uint16_t columns = pushCharacter(rune);
-    dimensions_.cursor_column(dimensions_.cursor_column() + columns);
+  history_.scroll(line, dimensions_.bottom_margin(), n);
+  if ( ! jumping_) {
+    draw_scroll(line, dimensions_.bottom_margin(), n);
   }
-  dimensions_.cursor_column(column);
-  repaint_ = PARTIAL;
+  move_cursor(1, line);
+  repaint_ = FULL;
 }
 
+/* relative moves stop at the edges of the screen */
 void Screen::move_cursor_forward(const int n) {
-  const uint16_t column = Screen::column() + n;
-  if (dimensions_.columns() >= column) {
-    history_.move_cursor_forward(n);
-    dimensions_.cursor_column(column);
-  } else {
-    assert(!"UNRECHEABLE");
-  }
+  move_cursor(std::min<int32_t>(column() + n, columns()), line());
 }
 
 void Screen::move_cursor_backward(const int n) {
-  const uint16_t column = Screen::column() - n;
-  if (0 < column) {
-    history_.move_cursor_backward(n);
-    dimensions_.cursor_column(column);
-  } else {
-    assert(!"UNRECHEABLE");
-  }
+  move_cursor(std::max<int32_t>(std::min<int32_t>(column(), columns()) - n, 1), line());
 }
 
 void Screen::move_cursor_down(const int n) {
-  const uint16_t line = Screen::line() + n;
-  if (dimensions_.lines() >= line) {
-    history_.move_cursor_down(n);
-    dimensions_.cursor_line(line);
-  } else {
-    assert(!"UNRECHEABLE");
-  }
+  move_cursor(std::min<int32_t>(column(), columns()), std::min<int32_t>(line() + n, lines()));
 }
 
 void Screen::move_cursor_up(const int n) {
-  uint16_t line = Screen::line() - n;
-  if (0 == line) {
-    line = 1;
-  }
-  history_.move_cursor_up(n);
-  dimensions_.cursor_line(line);
+  move_cursor(std::min<int32_t>(column(), columns()), std::max<int32_t>(line() - n, 1));
 }
 
 void Screen::erase_display() {
@@ -795,287 +398,199 @@ void Screen::erase_display() {
 
 void Screen::erase_scrollback() {
   history_.erase_scrollback();
+  if (search_) {
+    /* offsets no longer point at the same text */
+    search(pattern_, regex_);
+  }
+}
+
+void Screen::search(const std::string & pattern, const bool regex) {
+  search_.reset();
+  pattern_ = pattern;
+  regex_ = regex;
+  searched_ = false;
+  matches_.clear();
+  match_.reset();
+  search_ = std::make_unique<search::Search>(history_.snapshot(), search::Query{
+    .pattern = pattern,
+    .regex = regex,
+    .fold = search::smart_case(pattern), });
+  status();
+  repaint_ = FULL;
 }
 
-int32_t Screen::overflow() {
-  int32_t result = 0;
-  if ( ! dimensions_.overflow()) {
-    result = dimensions_.surface_height() - dimensions_.line_to_pixel(line() + 1);
-  }
-  return result;
+void Screen::stop_search() {
+  search_.reset();
+  matches_ = {};
+  match_.reset();
+  show_title(title_);
+  repaint_ = FULL;
 }
 
-void Screen::recreateFromScrollback(const uint64_t index) {
-  if (0 == index) {
-    std::cerr << __FILE__ << ":" << __LINE__ << " " << __func__ << " index is less than or equal to 0." << std::endl;
+void Screen::search_next(const bool older) {
+  if (matches_.empty()) {
     return;
   }
-  assert(0 < index);
-  History::ReverseIterator end = history_.reverse_iterator(index);
-  if (L'\n' == *end) {
-    ++end;
-  } else {
-    assert(L'\0' != *end);
+  if ( ! match_.has_value()) {
+    match_ = 0;
+  } else if (older && matches_.size() > *match_ + 1) {
+    ++*match_;
+  } else if ( ! older && 0 < *match_) {
+    --*match_;
   }
-  History::ReverseIterator iterator = end;
-  const uint64_t lines = history_.count_lines(iterator, history_.rend(), dimensions_.lines());
-  if (L'\n' == *iterator || L'\0' == *iterator) {
-    --iterator;
-  }
-  const int32_t page_size = lines * dimensions_.line_height();
-  Pages::Entry & page = pages_.emplace_front(page_size);
-  page.index = std::distance(iterator, history_.rend());
-  page.framebuffer.bind();
-  Rectangle target{
-    .x = 0,
-    .y = dimensions_.surface_height() - dimensions_.line_height(),
-    .width = dimensions_.glyph_width(),
-    .height = dimensions_.line_height(),
-  };
-  int16_t cursor_column = 1;
-  for (uint16_t columns = 1; end <= iterator; --iterator) {
-    target.width = dimensions_.glyph_width();
-    rune::Rune rune = *iterator;
-    if (rune.iscontrol()) {
-      switch (rune.character) {
-      case L'\n': // new line
-        cursor_column = 1;
-        target.y -= dimensions_.line_height();
-        target.x = 0;
-        continue;
-      case L'\t': // horizontal tab
-        columns = 8 - (cursor_column % 8);
-        target.width *= columns;
-        rune.character = L' ';
-        break;
-      default:
-        std::cerr << static_cast<int>(rune.character) << std::endl;
-        assert(!"UNIMPLEMENTED");
-        break;
-      }
-    }
-    const bool wrap = dimensions_.columns() < cursor_column;
-    if (wrap) {
-      cursor_column = 1;
-      target.y -= dimensions_.line_height();
-      target.x = 0;
-    }
-#if 1
-    glEnable(GL_SCISSOR_TEST);
-    target(glScissor);
-    rune.backgroundColor(glClearColor);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_SCISSOR_TEST);
-#endif
-    renderCharacter(target, rune);
-    target.x += target.width;
-    cursor_column += columns;
-  }
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-  glBindTexture(GL_TEXTURE_2D, 0);
-}
-
-void Screen::recreateFromActiveHistory() {
-  assert(0 < history_.active_size());
-  const int32_t pageSize = dimensions_.lines() * dimensions_.line_height();
-  Pages::Entry & page = pages_.emplace_front(pageSize);
-  page.index = history_.scrollback_size();
-  page.framebuffer.bind();
-  Rectangle target{
-    .x = 0,
-    .y = dimensions_.surface_height() - dimensions_.line_height(),
-    .width = dimensions_.glyph_width(),
-    .height = dimensions_.line_height(),
-  };
-  const uint16_t columns = history_.columns();
-  uint16_t column = 1, last_column = 1, last_line = 1, stride = 1;
-  for (uint16_t i = 1; dimensions_.lines() >= i; ++i) {
-    for (uint16_t j = 1; columns > j; ++j) {
-      target.width = dimensions_.glyph_width();
-      const uint32_t index = (i - 1) * columns + j;
-      rune::Rune rune = history_.at(index);
-      if (rune.iscontrol()) {
-        switch (rune.character) {
-        case L'\n':
-          break;
-
-        case L'\0':
-          break;
-
-        case L'\t': // horizontal tab
-          stride = 8 - (column % 8);
-          if (columns < column + stride) {
-            stride = columns - column;
-          }
-          target.width *= stride;
-          rune.character = L' ';
-          break;
-
-        default:
-          std::cerr << static_cast<int>(rune.character) << std::endl;
-          assert(!"UNIMPLEMENTED");
-          break;
-        }
-      }
-      if (static_cast<bool>(rune.character)) {
-        if (i >= last_line) {
-          last_line = i;
-          last_column = j + stride;
-        }
-#if 1
-        glEnable(GL_SCISSOR_TEST);
-        target(glScissor);
-        rune.backgroundColor(glClearColor);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_SCISSOR_TEST);
-#endif
-        renderCharacter(target, rune);
-      }
-      target.x += target.width;
-      column += stride;
-    }
-    column = 1;
-    target.y -= dimensions_.line_height();
-    target.x = 0;
-  }
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-  glBindTexture(GL_TEXTURE_2D, 0);
-
+  scroll_to(matches_[*match_].first);
+  status();
   repaint_ = FULL;
-
-  // assert(0 <= target.y);
-  // assert(dimensions_.lines() >= lines);
-  // assert(dimensions_.surface_width() >= target.x);
-
-  const auto cursor = history_.get_cursor();
-  dimensions_.displayed_lines(cursor.second);
-  dimensions_.move_cursor(cursor.first + 1, cursor.second);
 }
 
-Pages::Entry & Pages::emplace_front(const int32_t height) {
-  assert(0 < height);
-  assert(0 < height_);
-  assert(height <= height_);
-  int64_t y = 0;
-  if (!container_.empty()) {
-    const Entry & front = container_.front();
-    y = Pages::front_y() - height;
+void Screen::drain() {
+  if ( ! search_) {
+    return;
   }
-
-  const Rectangle_Y rectangle{
-    .x = 0,
-    .y = y,
-    .width = width_,
-    .height = height,
-  };
-
-  Pages::Entry & page = container_.emplace_front(new_entry(rectangle, 0));
-
-  if (1 == container_.size()) {
-    current_ = container_.begin();
+  const std::size_t size = matches_.size();
+  for (search::Match * match = search_->queue().front(); nullptr != match && MATCHES > matches_.size(); match = search_->queue().front()) {
+    matches_.emplace_back(history_.index(match->offset), history_.index(match->offset + match->size));
+    search_->queue().pop();
+  }
+  const bool searched = search_->done() && nullptr == search_->queue().front();
+  if (size != matches_.size() || searched != searched_) {
+    searched_ = searched;
+    status();
+    repaint_ = FULL;
   }
-
-  return page;
-}
-
-Pages::Entry Pages::new_entry(const Rectangle_Y & rectangle, const uint64_t index) {
-  assert(0 < width_);
-  assert(0 < height_);
-#if 0
-  const Color color{
-    .red = static_cast<float>(drand48()),
-    .green = static_cast<float>(drand48()),
-    .blue = static_cast<float>(drand48()),
-    .alpha = 1.f, };
-#else
-  const Color color = colors::black;
-#endif
-  return Entry{
-    .framebuffer = opengl::Framebuffer::New(width_, height_, color),
-    .area{
-      .x = 0,
-      .y = rectangle.y,
-      .width = width_, /* currently unused */
-      .height = rectangle.height,
-    },
-    .index = index,
-    };
 }
 
-bool Pages::has_alternative() const {
-  bool result = false;
-  for (const auto & entry : container_) {
-    result |= entry.alternative;
-    if (result) {
+/* the pattern, how many matches so far and which one is current */
+void Screen::status() {
+  std::string title = (regex_ ? "regex search: " : "search: ") + pattern_;
+  if ( ! pattern_.empty() && ! search_->valid()) {
+    title += " (invalid)";
+  } else if ( ! pattern_.empty()) {
+    title += " (";
+    if (match_.has_value()) {
+      title += std::to_string(*match_ + 1) + " of ";
+    }
+    title += std::to_string(matches_.size()) + (searched_ ? "" : "+") + " matches)";
+  }
+  show_title(title);
+}
+
+std::vector<std::pair<Rectangle, bool>> Screen::highlights(const int64_t offset_y) const {
+  std::vector<std::pair<Rectangle, bool>> result;
+  const int64_t height = dimensions_.line_height();
+  /* where the screen starts, rows of scrollback are right above it */
+  const int64_t top = static_cast<int64_t>(dimensions_.scrollback_lines()) * height - offset_y;
+  const int64_t nearest = std::max<int64_t>(0, (top - dimensions_.surface_height()) / height);
+  const int64_t farthest = (top + height) / height;
+  if (0 >= farthest) {
+    return result;
+  }
+  const int32_t thickness = std::max<int32_t>(2, height / 8);
+  const uint16_t columns = history_.columns() - 1;
+
+  /* matches are newest first, so the rows above the screen grow along them */
+  auto iterator = std::partition_point(matches_.begin(), matches_.end(),
+      [&](const auto & match) { return nearest > static_cast<int64_t>(history_.locate(match.first).first); });
+  for (; matches_.end() != iterator; ++iterator) {
+    const auto & [begin, end] = *iterator;
+    if (farthest < static_cast<int64_t>(history_.locate(end - 1).first)) {
       break;
     }
+    const auto [row, first] = history_.locate(begin);
+    int64_t rows = row;
+    uint16_t column = first;
+    for (uint64_t runes = end - begin; 0 < runes && 0 < rows; --rows, column = 1) {
+      const uint64_t span = std::min<uint64_t>(runes, std::max<int32_t>(1, columns + 1 - column));
+      runes -= span;
+      if (nearest > rows || farthest < rows) {
+        continue;
+      }
+      result.emplace_back(Rectangle{
+        .x = dimensions_.column_to_pixel(column),
+        .y = static_cast<int32_t>(dimensions_.surface_height() - (top - rows * height + height)),
+        .width = static_cast<int32_t>(span * dimensions_.glyph_width()),
+        .height = thickness,
+      }, match_.has_value() && matches_.begin() + *match_ == iterator);
+    }
   }
   return result;
 }
 
-void Screen::draw_cursor(const int32_t offset) const {
-  Rectangle target{static_cast<Rectangle>(dimensions_)};
-  target.y = offset;
-  glEnable(GL_SCISSOR_TEST);
-  target(glScissor);
-  colors::white(glClearColor);
-  glClear(GL_COLOR_BUFFER_BIT);
-  glDisable(GL_SCISSOR_TEST);
-}
-
-void Damage::emplace(Rectangle && r) {
-  if (container_.empty()) {
-    container_.emplace(std::move(r));
+/*
+ * scrolls straight to where the row holding a scrollback rune is mid
+ * screen, only the pages around it are drawn.
+ */
+void Screen::scroll_to(const uint64_t index) {
+  const int64_t height = dimensions_.line_height();
+  const int64_t rows = history_.locate(index).first;
+  const uint64_t target = std::max<int64_t>(0, rows * height + (dimensions_.surface_height() - height) / 2);
+  if (dimensions_.scroll_y() == target) {
     return;
   }
-#if 1 // turn optimization on/off
-  auto iterator = container_.lower_bound(r);
-  if (container_.end() == iterator) {
-    --iterator;
-  }
-  if (iterator->overlaps(r)) {
-    if (iterator->contains(r)) {
-      return;
-    }
-    const bool incorporated = r.incorporate(*iterator);
-    if (incorporated) {
-      container_.erase(iterator);
-    }
-  }
-#endif
-  container_.emplace(std::move(r));
+  dimensions_.scroll_y(target);
+  draw_scrollback();
+  repaint_ = FULL;
 }
 
-uint32_t Damage::area() const {
-  uint32_t area = 0;
-  for (const auto & item : container_) {
-    area += item.area();
+int32_t Screen::overflow() {
+  int32_t result = 0;
+  if ( ! dimensions_.overflow()) {
+    result = dimensions_.surface_height() - dimensions_.line_to_pixel(line() + 1);
   }
-  return area;
+  return result;
 }
 
-void Screen::alternative(const bool mode) {
-  dimensions_.enable_overflow( ! mode);
-  history_.alternative(mode);
-  resize(dimensions_.surface_width(), dimensions_.surface_height());
+void Screen::erase_line_right() {
+  history_.erase_line_right();
+  if ( ! jumping_) {
+    draw_erase_line_right();
+  }
+  repaint_ = PARTIAL;
 }
 
-void Screen::new_line() {
-  Rectangle_Y rectangle = static_cast<Rectangle_Y>(dimensions_);
-  pages_.draw(rectangle, history_.size());
-}
+void Screen::recreateFromActiveHistory() {
+  assert(0 < history_.active_size());
+  draw_active_history();
 
-/* transaction */
-void Screen::begin(const uint64_t size) {
-  history_.begin(size);
-  long_transaction_ = true;
+  repaint_ = FULL;
+
+  const auto cursor = history_.get_cursor();
+  dimensions_.displayed_lines(cursor.second);
+  /* the column may be one past the last, pending a wrap */
+  dimensions_.move_cursor(1, cursor.second);
+  dimensions_.cursor_column(cursor.first + 1);
 }
 
-void Screen::commit() {
-  history_.commit();
-  if ( ! long_transaction_) {
+/*
+ * both screens stay resident, switching swaps their grids, pages and
+ * dimensions instead of laying out and drawing history again. the primary
+ * is only drawn again when the surface changed meanwhile or it was left
+ * while jump scrolling, without its pages up to date.
+ */
+void Screen::alternative(const bool mode) {
+  if (mode == history_.is_alternative()) {
+    return;
+  }
+  history_.alternative(mode);
+  swap_pages(mode);
+  if (mode) {
+    /* pages not drawn while jumping, no surface has them drawn on the way back */
+    const Dimensions none;
+    inactive_ = jumping_ ? none : dimensions_;
+    dimensions_.rewind();
+    dimensions_.margins(0, 0);
+    dimensions_.enable_overflow(false);
+    history_.margins(0, 0);
+  } else if (inactive_.surface_width() == dimensions_.surface_width()
+      && inactive_.surface_height() == dimensions_.surface_height()) {
+    dimensions_ = inactive_;
+    if (dimensions_.has_margins()) {
+      history_.margins(dimensions_.top_margin(), dimensions_.bottom_margin());
+    }
+  } else {
+    dimensions_.enable_overflow(true);
+    resize(dimensions_.surface_width(), dimensions_.surface_height());
     return;
   }
-  resize(dimensions_.surface_width(), dimensions_.surface_height());
-  long_transaction_ = false;
+  repaint_ = FULL;
 }
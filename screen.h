@@ -2,94 +2,25 @@
 
 #pragma once
 
-#include <list>
-#include <set>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
 
-#include "character-map.h"
 #include "dimensions.h"
-#include "font.h"
-#include "freetype.h"
 #include "history.h"
-#include "opengl.h"
 #include "rune.h"
+#include "search.h"
 #include "types.h"
-#include "wayland.h"
-
-struct Damage {
-  // expensive
-  using Container = std::set<Rectangle>;
-  auto area() const -> uint32_t;
-  auto clear() -> void { container_.clear(); }
-  auto emplace(Rectangle &&) -> void;
-  auto empty() const -> bool { return container_.empty(); }
-
-  template <typename Container>
-  void transfer(Container & c) {
-    while ( ! container_.empty()) {
-      c.emplace(c.cend(), container_.extract(container_.begin()).value());
-    }
-  }
-
-  Container container_;
-};
-
-struct Pages {
-private:
-  struct Entry {
-    opengl::Framebuffer framebuffer;
-    opengl::Framebuffer alternative;
-    Rectangle_Y area;
-    uint64_t index = 0;
-  };
-
-  using Container = std::list<Entry>;
-
-public:
-  struct Drawer {
-    ~Drawer();
-    auto alternative() const -> bool; 
-    auto clear(const Color & color) const -> void;
-    auto create_alternative() const -> void;
-    const Rectangle target;
-  private:
-    Drawer(const Pages &, Entry &, Rectangle &&);
-    Entry & entry_;
-    const Pages & pages_;
-    friend class Pages;
-  };
-
-  Pages(const uint8_t cap = 0) : cap_(cap) { assert( 1 < cap_); }
-
-  auto draw(Rectangle_Y, const uint64_t) -> Drawer;
-  auto emplace_front(const int32_t) -> Entry &;
-  auto front_index() const -> uint64_t { return container_.empty() ? 0 : container_.front().index; }
-  auto front_y() const -> int64_t { return container_.empty() ? 0 : container_.front().area.y; }
-  auto has_alternative() const -> bool;
-  auto is_current(Entry & entry) const -> bool { return current_->framebuffer == entry.framebuffer; }
-  auto paint(const uint16_t frame = 0) -> bool;
-  auto repaint(const Rectangle, const int64_t, const bool alternative = false) -> void;
-  auto reset(const uint16_t, const uint16_t) -> void;
-  auto total_height() const -> uint32_t;
-
-  constexpr auto height() const { return height_; }
-  constexpr auto scale_height() const { return 2.f / height_; }
-  constexpr auto scale_width() const { return 2.f / width_; }
-
-private:
-  auto new_entry(const Rectangle_Y &, const uint64_t) -> Entry;
-  auto update(Rectangle_Y &, const uint64_t) -> Entry &;
-
-  Container container_;
-  Container::iterator current_ = container_.end();
-
-  opengl::Shader glProgram_;
 
-  uint16_t height_ = 0;
-  uint16_t width_ = 0;
-  uint8_t cap_ = 0;
-
-  friend class Screen;
-};
+namespace wayland {
+struct Connection;
+} // end of namespace wayland
 
 struct Screen {
   enum Repaint {
@@ -98,9 +29,32 @@ struct Screen {
     FULL,
   };
 
+  /*
+   * jump scroll, once output scrolls more than a threshold within a frame
+   * glyphs are no longer drawn, only history is updated and the final grid
+   * is rasterized once per frame.
+   */
+  struct JumpScroll {
+    /* screens scrolled within a frame before jumping, 0 never jumps */
+    uint16_t screens = 1;
+    /* frames scrolling less than that before drawing glyphs again */
+    uint16_t frames = 2;
+  };
+
+  struct Jumps {
+    /* frames rasterized from history */
+    uint64_t frames = 0;
+    /* screens scrolled by without ever being drawn */
+    uint64_t skipped = 0;
+
+    friend std::ostream & operator << (std::ostream &, const Jumps &);
+  };
+
   static Screen New(const wayland::Connection &);
+  /* no surface nor rendering, for benchmarks and tests */
+  static Screen Headless(const uint16_t, const uint16_t);
 
-  ~Screen() = default;
+  ~Screen();
   Screen() = delete;
 
   Screen(const Screen &) = delete;
@@ -116,53 +70,133 @@ struct Screen {
   auto move_cursor(const int, const int) -> void;
 
   auto alternative(const bool) -> void;
+  auto at(const uint16_t column, const uint16_t line) const -> const rune::Rune & { return history_.at(column, line); }
   auto backspace() -> void;
-  auto begin(const uint64_t size = 0) -> void;
   auto changeScrollY(int32_t) -> void;
+  auto checksum() const -> uint64_t { return history_.checksum(); }
   auto column() const -> int32_t { return dimensions_.cursor_column(); }
   auto columns() const -> int32_t { return dimensions_.columns(); }
-  auto commit() -> void;
+  auto delete_lines(const int) -> void;
   auto drag(const uint16_t, const uint16_t) -> void;
   auto erase(const int) -> void;
+  auto erase_characters(const int) -> void;
   auto erase_display() -> void;
   auto erase_line_right() -> void;
   auto erase_scrollback() -> void;
+  /* number of buffer swaps so far */
+  auto frames() const -> uint64_t { return frames_; }
+  auto indexed() const -> const trigram::Stats & { return history_.indexed(); }
   auto insert(const int) -> void;
+  auto insert_lines(const int) -> void;
+  auto jump_scroll(const JumpScroll & j) -> void { jump_scroll_ = j; }
+  auto jumps() const -> const Jumps & { return jumps_; }
   auto line() const -> int32_t { return dimensions_.cursor_line(); }
   auto lines() const -> int32_t { return dimensions_.lines(); }
+  /* DECSTBM, lines 1 based */
+  auto margins(const uint16_t, const uint16_t) -> void;
+  auto print(std::span<const rune::Rune>) -> void;
   auto pushBack(rune::Rune &&) -> void;
   auto repaint(const bool force = false, const bool alternative = false) -> void;
   auto resetScroll() -> void { dimensions_.scroll_y(0); }
   auto resize(const uint16_t, const uint16_t) -> void;
   auto reverse_line_feed() -> void;
+  /* SU and SD, scrolls the region n lines up or down when negative */
+  auto scroll(const int) -> void;
+  /*
+   * searches scrollback as the pattern is typed, matches are highlighted as
+   * they stream in, newest first, without drawing pages again.
+   */
+  auto search(const std::string &, const bool regex) -> void;
+  /* scrolls to the next older match, or newer */
+  auto search_next(const bool older) -> void;
+  auto searching() const -> bool { return static_cast<bool>(search_); }
   auto setTitle(const std::string &) -> void;
   auto shouldRepaint() -> bool { return FULL == repaint_; }
+  /* moves older scrollback to disk */
+  auto spill(const spill::Options & o) -> void { history_.spill(o); }
+  auto stop_search() -> void;
+  /* indexes scrollback for searching, within a budget of bytes */
+  auto trigrams(const std::size_t b) -> void { history_.trigrams(b); }
+  auto synchronize(const bool) -> void;
+  auto synchronized() const -> bool { return synchronized_.has_value(); }
 
   std::function<void (int32_t, int32_t)> onResize;
 
 private:
-  Screen(std::unique_ptr<wayland::Surface> &&);
+  /*
+   * rendering lives in a backend, screen-opengl.cc draws through opengl on a
+   * wayland surface and headless/screen.cc keeps nothing but the grid. each
+   * defines the functions right below, along with the constructors,
+   * changeScrollY, new_line, pushCharacter(s) and setTitle.
+   */
+  struct Backend;
+
+  Screen(std::unique_ptr<Backend> &&);
+
+  auto clear() -> void;
+  auto draw_active_history() -> void;
+  auto draw_blank(const uint16_t, const int) -> void;
+  auto draw_erase_line_right() -> void;
+  auto draw_scroll(const uint16_t, const uint16_t, const int) -> void;
+  auto draw_shift(const uint16_t, const int) -> void;
+  auto draw_matches(const int64_t) const -> void;
+  /* covers the screen with scrollback as far as it is scrolled back */
+  auto draw_scrollback() -> void;
+  auto present(const bool, const bool) -> void;
+  auto reset(const uint16_t, const uint16_t) -> void;
+  auto show_title(const std::string &) -> void;
+  auto swap_pages(const bool) -> void;
 
   auto draw_cursor(const int32_t) const -> void;
   auto draw() -> void;
+  /* takes the matches found since the last frame */
+  auto drain() -> void;
+  /* bars under the visible matches, in surface coordinates, and whether each is the current one */
+  auto highlights(const int64_t) const -> std::vector<std::pair<Rectangle, bool>>;
   auto history() -> History & { return history_; }
-  auto makeCurrent() const -> void { surface_->egl().makeCurrent(); }
+  auto land() -> void;
+  auto line_feed() -> void;
+  auto makeCurrent() const -> void;
   auto new_line() -> void;
   auto overflow() -> int32_t;
   auto pushCharacter(rune::Rune) -> uint16_t;
+  auto pushCharacters(std::span<const rune::Rune>) -> void;
   auto recreateFromActiveHistory() -> void;
-  auto recreateFromScrollback(const uint64_t index) -> void;
-  auto renderCharacter(const Rectangle &, const rune::Rune &) -> void;
+  /* a page of the rows before index, its bottom at y */
+  auto recreateFromScrollback(const uint64_t index, const int64_t y) -> void;
+  auto redraw() -> void;
+  auto renderCharacter(const Rectangle &, const rune::Rune &, const bool conceal_blinking = false) -> void;
+  auto renderCharacters(const Rectangle &, std::span<const rune::Rune>, const bool) -> void;
+  auto scroll_to(const uint64_t) -> void;
+  auto scrolled() -> void;
   auto select(const Rectangle & rectangle) -> void;
+  auto status() -> void;
   auto swapBuffers(bool fullSwap = true) -> void;
+  auto withheld() -> bool;
 
-  CharacterMap characters_;
+  std::unique_ptr<Backend> backend_;
   Dimensions dimensions_;
+  /* dimensions of the screen not shown, primary or alternative */
+  Dimensions inactive_;
   History history_;
-  Pages pages_{/* total number of entries, where 2 is the minimum */ 2};
-  Damage damage_;
   Repaint repaint_ = NO;
-  opengl::Shader glProgram_;
-  std::unique_ptr<wayland::Surface> surface_;
-  bool long_transaction_ = false;
+  uint64_t frames_ = 0;
+  JumpScroll jump_scroll_;
+  Jumps jumps_;
+  bool jumping_ = false;
+  /* lines scrolled since the last frame and frames since it scrolled a lot */
+  uint32_t scrolled_ = 0;
+  uint16_t calm_ = 0;
+  /* when the application opened a synchronized update */
+  std::optional<std::chrono::steady_clock::time_point> synchronized_;
+  /* the one set by the application, shown again once searching ends */
+  std::string title_ = "Moonshot";
+  std::unique_ptr<search::Search> search_;
+  std::string pattern_;
+  bool regex_ = false;
+  bool searched_ = false;
+  /* scrollback runes matched, newest first, up to MATCHES, and the one scrolled to */
+  std::vector<std::pair<uint64_t, uint64_t>> matches_;
+  std::optional<std::size_t> match_;
+  constexpr static std::size_t MATCHES = 1 << 20;
 };
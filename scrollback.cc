@@ -0,0 +1,536 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+
+#include <cassert>
+
+#include "lz.h"
+#include "scrollback.h"
+#include "utf8.h"
+
+namespace {
+/* text was encoded by push_back, it holds nothing but valid sequences */
+std::size_t length(const unsigned char lead) {
+  return 0x80 > lead ? 1 : 0xe0 > lead ? 2 : 0xf0 > lead ? 3 : 4;
+}
+
+wchar_t decode(const unsigned char * const bytes) {
+  switch (length(bytes[0])) {
+  case 1:
+    return bytes[0];
+  case 2:
+    return ((bytes[0] & 0x1f) << 6) | (bytes[1] & 0x3f);
+  case 3:
+    return ((bytes[0] & 0x0f) << 12) | ((bytes[1] & 0x3f) << 6) | (bytes[2] & 0x3f);
+  default:
+    return ((bytes[0] & 0x07) << 18) | ((bytes[1] & 0x3f) << 12)
+      | ((bytes[2] & 0x3f) << 6) | (bytes[3] & 0x3f);
+  }
+}
+
+/* fnv-1a */
+uint64_t hash(const std::string_view bytes) {
+  uint64_t h = 0xcbf29ce484222325;
+  for (const char c : bytes) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+  }
+  return h;
+}
+/*
+ * same lengths with nothing to show, new lines where they were. runes
+ * straddling either end are left alone, their other half may be intact.
+ */
+void blank(std::string & text) {
+  constexpr const char * BLANKS[] = { " ", "\xc2\xa0", "\xe2\xa0\x80", "\xf3\xa0\x80\xa0", };
+  std::size_t i = 0;
+  while (text.size() > i && 0x80 == (text[i] & 0xc0)) {
+    ++i;
+  }
+  for (std::size_t size = 0; text.size() > i; i += size) {
+    size = length(text[i]);
+    if (text.size() >= i + size && '\n' != text[i]) {
+      text.replace(i, size, BLANKS[size - 1]);
+    }
+  }
+}
+} // end of annonymous namespace
+
+Scrollback::Iterator::Iterator(const Scrollback & scrollback, const uint64_t index) :
+  scrollback_(&scrollback), index_(index) {
+  assert(scrollback.size_ >= index);
+  if (scrollback.size_ == index) {
+    offset_ = scrollback.sealed() + scrollback.tail_.size();
+  } else {
+    offset_ = scrollback.offsets_[index / STRIDE];
+    for (uint64_t i = index - index % STRIDE; index > i; ++i) {
+      offset_ += length(byte(offset_));
+    }
+  }
+  const auto iterator = std::upper_bound(scrollback.runs_.begin(), scrollback.runs_.end(), index,
+      [](const uint64_t i, const Run & run) { return i < run.index; });
+  run_ = scrollback.runs_.begin() == iterator ? 0 : iterator - scrollback.runs_.begin() - 1;
+}
+
+unsigned char Scrollback::Iterator::byte(const uint64_t offset) const {
+  if (chunk_.begin > offset || chunk_.end <= offset) {
+    chunk_ = scrollback_->chunk(offset);
+  }
+  return chunk_.data[offset - chunk_.begin];
+}
+
+rune::Rune Scrollback::Iterator::operator * () const {
+  assert(scrollback_->size_ > index_);
+  const std::size_t size = length(byte(offset_));
+  const uint32_t attributes = scrollback_->runs_[run_].attributes;
+  if (chunk_.end >= offset_ + size) {
+    return rune::Rune(decode(reinterpret_cast<const unsigned char *>(chunk_.data + offset_ - chunk_.begin)), attributes);
+  }
+  /* the sequence straddles two blocks */
+  unsigned char bytes[4];
+  for (std::size_t i = 0; size > i; ++i) {
+    bytes[i] = byte(offset_ + i);
+  }
+  return rune::Rune(decode(bytes), attributes);
+}
+
+Scrollback::Iterator & Scrollback::Iterator::operator ++ () {
+  offset_ += length(byte(offset_));
+  ++index_;
+  const Chunked<Run> & runs = scrollback_->runs_;
+  if (runs.size() > run_ + 1 && runs[run_ + 1].index <= index_) {
+    ++run_;
+  }
+  return *this;
+}
+
+Scrollback::Iterator & Scrollback::Iterator::operator -- () {
+  assert(0 < index_);
+  --index_;
+  do {
+    --offset_;
+  } while (0x80 == (byte(offset_) & 0xc0));
+  if (0 < run_ && scrollback_->runs_[run_].index > index_) {
+    --run_;
+  }
+  return *this;
+}
+
+/* short hops step, longer ones start over from the nearest offset */
+Scrollback::Iterator & Scrollback::Iterator::operator += (const difference_type n) {
+  if (0 <= n && STRIDE >= n) {
+    for (difference_type i = 0; n > i; ++i) {
+      ++*this;
+    }
+  } else if (0 > n && -static_cast<difference_type>(STRIDE) <= n) {
+    for (difference_type i = 0; n < i; --i) {
+      --*this;
+    }
+  } else {
+    *this = Iterator(*scrollback_, index_ + n);
+  }
+  return *this;
+}
+
+Scrollback::Chunk Scrollback::chunk(const uint64_t offset) const {
+  assert(sealed() + tail_.size() > offset);
+  if (sealed() <= offset) {
+    return Chunk{ .data = tail_.data(), .begin = sealed(), .end = sealed() + tail_.size(), };
+  }
+  const std::size_t index = offset / BLOCK;
+  const Block & block = blocks_[index];
+  Chunk chunk{ .begin = index * BLOCK, .end = (index + 1) * BLOCK, };
+  if ( ! block.compressed) {
+    chunk.owner = block.bytes;
+    chunk.data = block.view().data();
+    return chunk;
+  } else {
+    const auto iterator = std::find_if(hot_.begin(), hot_.end(),
+        [&](const auto & entry) { return entry.first == index; });
+    if (hot_.end() != iterator) {
+      std::rotate(hot_.begin(), iterator, iterator + 1);
+    } else {
+      if (HOT <= hot_.size()) {
+        hot_.pop_back();
+      }
+      hot_.emplace(hot_.begin(), index,
+          std::make_shared<const std::string>(lz::decompress(block.view(), BLOCK)));
+    }
+    chunk.owner = hot_.front().second;
+  }
+  chunk.data = chunk.owner->data();
+  return chunk;
+}
+
+void Scrollback::clear() {
+  blocks_.clear();
+  hashes_.clear();
+  owners_.clear();
+  stored_ = blanks_ = 0;
+  hot_.clear();
+  spilled_ = expired_ = 0;
+  unfiltered_ = 0;
+  filters_ = {};
+  if (file_ && 1 < file_.use_count()) {
+    /* a snapshot still reads the old one */
+    spill(spill::Options(*spill_));
+  } else if (file_) {
+    file_->clear();
+  }
+  tail_.clear();
+  runs_.clear();
+  offsets_.clear();
+  lines_.clear();
+  ends_.clear();
+  tabs_.clear();
+  layouts_ = {};
+  size_ = 0;
+}
+
+uint64_t Scrollback::index(const uint64_t offset) const {
+  assert(sealed() + tail_.size() >= offset);
+  if (offsets_.empty()) {
+    return 0;
+  }
+  const std::size_t stride = std::upper_bound(offsets_.begin(), offsets_.end(), offset) - offsets_.begin() - 1;
+  uint64_t index = stride * STRIDE;
+  /* counts the bytes leading a rune */
+  for (uint64_t o = offsets_[stride]; offset > o; ) {
+    const Chunk chunk = this->chunk(o);
+    for (const uint64_t end = std::min(offset, chunk.end); end > o; ++o) {
+      index += 0x80 != (chunk.data[o - chunk.begin] & 0xc0);
+    }
+  }
+  return index;
+}
+
+std::string Scrollback::line(const uint64_t i) const {
+  assert(lines_.size() > i);
+  const uint64_t END = lines_[i];
+  std::string text;
+  text.reserve(END - (0 == i ? 0 : lines_[i - 1] + 1));
+  for (uint64_t offset = 0 == i ? 0 : lines_[i - 1] + 1; END > offset; ) {
+    const Chunk chunk = this->chunk(offset);
+    const uint64_t end = std::min(END, chunk.end);
+    text.append(chunk.data + offset - chunk.begin, end - offset);
+    offset = end;
+  }
+  return text;
+}
+
+std::size_t Scrollback::memory() const {
+  std::size_t layouts = 0;
+  for (const Layout & layout : layouts_) {
+    layouts += (layout.above.capacity() + layout.below.capacity()) * sizeof(uint64_t);
+    for (const auto & [line, wraps] : layout.wraps) {
+      layouts += sizeof(line) + sizeof(wraps) + wraps.starts.capacity() * sizeof(uint64_t);
+    }
+  }
+  return layouts + stored_ + blanks_ + filters_.bytes
+    + blocks_.capacity() * sizeof(Block)
+    + hashes_.size() * (sizeof(uint64_t) + sizeof(std::size_t) + sizeof(void *))
+    + owners_.size() * (sizeof(void *) + sizeof(std::size_t) + sizeof(void *))
+    + hot_.size() * BLOCK
+    + tail_.capacity()
+    + runs_.capacity() * sizeof(Run)
+    + offsets_.capacity() * sizeof(uint64_t)
+    + lines_.capacity() * sizeof(uint64_t)
+    + ends_.capacity() * sizeof(uint64_t)
+    + tabs_.capacity() * sizeof(uint64_t);
+}
+
+void Scrollback::push_back(const rune::Rune & rune) {
+  assert(static_cast<bool>(rune));
+  if (0 == size_ % STRIDE) {
+    offsets_.push_back(sealed() + tail_.size());
+  }
+  /* new lines take whatever attributes are current, they are never drawn */
+  const bool new_line = L'\n' == rune.character;
+  if (runs_.empty() || ( ! new_line && runs_.back().attributes != rune.id())) {
+    runs_.push_back(Run{ .index = size_, .attributes = rune.id(), });
+  }
+  if (new_line) {
+    lines_.push_back(sealed() + tail_.size());
+    ends_.push_back(size_);
+  } else if (L'\t' == rune.character && (tabs_.empty() || lines_.size() != tabs_.back())) {
+    tabs_.push_back(lines_.size());
+  }
+  char buffer[4];
+  tail_.append(buffer, utf8::encode(rune.character, buffer));
+  ++size_;
+  if (BLOCK <= tail_.size()) {
+    seal();
+  }
+}
+
+/* the first BLOCK bytes of the tail, runes may straddle two blocks */
+void Scrollback::seal() {
+  const std::string_view text(tail_.data(), BLOCK);
+  std::string bytes = lz::compress(text);
+  Block block{ .newline = text.find('\n'), .compressed = BLOCK > bytes.size(), };
+  if ( ! block.compressed) {
+    bytes.assign(text);
+  }
+  if (0 < trigrams_) {
+    auto filter = std::make_shared<trigram::Filter>();
+    filter->add(0 == sealed() ? std::string_view() : std::string_view(last_, sizeof(last_)), text);
+    block.filter = std::move(filter);
+    ++filters_.blocks;
+    filters_.bytes += sizeof(trigram::Filter);
+  }
+  std::copy(text.end() - sizeof(last_), text.end(), last_);
+  tail_.erase(0, BLOCK);
+
+  /* spilled blocks are not shared, they may expire before this one */
+  const auto [iterator, inserted] = hashes_.try_emplace(hash(bytes), blocks_.size());
+  const Block * const same = inserted ? nullptr : &blocks_[iterator->second];
+  if (nullptr != same && same->bytes && same->compressed == block.compressed && *same->bytes == bytes) {
+    block.bytes = same->bytes;
+    ++owners_[block.bytes.get()];
+  } else {
+    if (nullptr != same && ! same->bytes) {
+      iterator->second = blocks_.size();
+    }
+    bytes.shrink_to_fit();
+    stored_ += bytes.capacity();
+    block.bytes = std::make_shared<const std::string>(std::move(bytes));
+    owners_.emplace(block.bytes.get(), 1);
+  }
+  blocks_.push_back(std::move(block));
+
+  /* the oldest filters go first */
+  for (; trigrams_ < filters_.bytes && blocks_.size() > unfiltered_; ++unfiltered_) {
+    if (blocks_[unfiltered_].filter) {
+      blocks_[unfiltered_].filter.reset();
+      --filters_.blocks;
+      filters_.bytes -= sizeof(trigram::Filter);
+    }
+  }
+
+  if ( ! file_) {
+    return;
+  }
+  /* the oldest blocks in memory go first */
+  for (; spill_->memory < stored_ && blocks_.size() > spilled_; ++spilled_) {
+    Block & spilled = blocks_[spilled_];
+    const spill::File::Extent extent = file_->write(spilled.view());
+    if (extent.bytes.empty()) {
+      break;
+    }
+    const auto owners = owners_.find(spilled.bytes.get());
+    assert(owners_.end() != owners);
+    if (0 == --owners->second) {
+      stored_ -= spilled.bytes->capacity();
+      owners_.erase(owners);
+    }
+    spilled.bytes.reset();
+    spilled.mapped = extent.bytes;
+    spilled.segment = extent.segment;
+  }
+  /* not while a snapshot may be reading the oldest segment */
+  while (0 < spill_->disk && spill_->disk < file_->size() && 1 < file_->segments() && 1 == file_.use_count()) {
+    expire();
+  }
+}
+
+/* blanks the blocks in the oldest segment, in memory since they compress to little */
+void Scrollback::expire() {
+  const uint64_t segment = file_->first();
+  for (; spilled_ > expired_ && segment == blocks_[expired_].segment; ++expired_) {
+    Block & block = blocks_[expired_];
+    std::string text = block.compressed ? lz::decompress(block.mapped, BLOCK) : std::string(block.mapped);
+    const auto iterator = hashes_.find(hash(block.mapped));
+    if (hashes_.end() != iterator && expired_ == iterator->second) {
+      hashes_.erase(iterator);
+    }
+    blank(text);
+    std::string bytes = lz::compress(text);
+    block.compressed = BLOCK > bytes.size();
+    if ( ! block.compressed) {
+      bytes = std::move(text);
+    }
+    bytes.shrink_to_fit();
+    blanks_ += bytes.capacity();
+    block.bytes = std::make_shared<const std::string>(std::move(bytes));
+    block.mapped = {};
+    std::erase_if(hot_, [this](const auto & entry) { return expired_ == entry.first; });
+  }
+  file_->expire();
+}
+
+Scrollback::Snapshot Scrollback::snapshot() const {
+  Snapshot snapshot;
+  snapshot.blocks_ = blocks_;
+  snapshot.tail_ = tail_;
+  snapshot.file_ = file_;
+  return snapshot;
+}
+
+std::string_view Scrollback::Snapshot::block(const std::size_t i) {
+  assert(blocks() > i);
+  if (blocks_.size() == i) {
+    return tail_;
+  }
+  const Block & block = blocks_[i];
+  if ( ! block.compressed) {
+    return block.view();
+  }
+  buffer_ = lz::decompress(block.view(), BLOCK);
+  return buffer_;
+}
+
+bool Scrollback::Snapshot::may_match(const std::size_t first, const std::size_t last, const std::vector<uint32_t> & hashes) const {
+  assert(last < blocks());
+  const auto has = [&](const uint32_t hash) {
+    for (std::size_t i = first; last >= i; ++i) {
+      /* the tail and blocks without a filter may hold anything */
+      if (blocks_.size() == i || ! blocks_[i].filter || blocks_[i].filter->has(hash)) {
+        return true;
+      }
+    }
+    return false;
+  };
+  return std::all_of(hashes.begin(), hashes.end(), has);
+}
+
+void Scrollback::trigrams(const std::size_t budget) {
+  trigrams_ = budget;
+  if (0 == unfiltered_ && 0 == filters_.blocks) {
+    /* blocks sealed so far go unfiltered */
+    unfiltered_ = blocks_.size();
+  }
+}
+
+void Scrollback::spill(const spill::Options & options) {
+  spill_ = options;
+  file_ = std::make_shared<spill::File>();
+  if ( ! file_->open(options.directory)) {
+    file_.reset();
+  }
+}
+
+bool Scrollback::has_tabs(const uint64_t line) const {
+  return std::binary_search(tabs_.begin(), tabs_.end(), line);
+}
+
+/* as the screen draws them, a tab stretches to the next multiple of 8 */
+const Scrollback::Wraps & Scrollback::wraps(Layout & layout, const uint64_t line) const {
+  Wraps * wraps = &scratch_;
+  if (LONG <= end(line) - begin(line)) {
+    wraps = &layout.wraps[line];
+  } else {
+    scratch_ = Wraps{};
+  }
+  if (wraps->starts.empty()) {
+    wraps->starts.push_back(begin(line));
+    wraps->walked = begin(line);
+  }
+  for (Iterator iterator(*this, wraps->walked); end(line) > iterator.index(); ++iterator) {
+    if (layout.width < wraps->column) {
+      wraps->column = 1;
+      wraps->starts.push_back(iterator.index());
+    }
+    wraps->column += L'\t' == (*iterator).character ? 8 - wraps->column % 8 : 1;
+  }
+  wraps->walked = end(line);
+  return *wraps;
+}
+
+/* of complete lines, even empty ones take a row */
+uint64_t Scrollback::rows(Layout & layout, const uint64_t line) const {
+  if (has_tabs(line)) {
+    return wraps(layout, line).starts.size();
+  }
+  return std::max<uint64_t>(1, (end(line) - begin(line) + layout.width - 1) / layout.width);
+}
+
+/*
+ * the new line belongs to the last row, while the end of the open line
+ * starts a new one once the last is full.
+ */
+uint64_t Scrollback::row(Layout & layout, const uint64_t line, const uint64_t index) const {
+  if (has_tabs(line)) {
+    const Wraps & wraps = this->wraps(layout, line);
+    const uint64_t row = std::upper_bound(wraps.starts.begin(), wraps.starts.end(), index) - wraps.starts.begin() - 1;
+    return row + (size_ == index && ends_.size() == line && layout.width < wraps.column ? 1 : 0);
+  }
+  const uint64_t row = (index - begin(line)) / layout.width;
+  return ends_.size() == line ? row : std::min(row, rows(layout, line) - 1);
+}
+
+uint64_t Scrollback::start(Layout & layout, const uint64_t line, const uint64_t row) const {
+  if (has_tabs(line)) {
+    const std::vector<uint64_t> & starts = wraps(layout, line).starts;
+    return starts.size() > row ? starts[row] : size_;
+  }
+  return std::min(end(line), begin(line) + row * layout.width);
+}
+
+Scrollback::Layout & Scrollback::layout(const uint16_t width) const {
+  assert(0 < width);
+  if (width == layouts_[1].width) {
+    std::swap(layouts_[0], layouts_[1]);
+  } else if (width != layouts_[0].width) {
+    layouts_[1] = std::move(layouts_[0]);
+    layouts_[0] = Layout{ .width = width, .anchor = ends_.size(), };
+  }
+  Layout & layout = layouts_[0];
+  /* lines completed since */
+  for (uint64_t line = layout.anchor + layout.below.size(); ends_.size() > line; ++line) {
+    layout.below.push_back((layout.below.empty() ? 0 : layout.below.back()) + rows(layout, line));
+  }
+  return layout;
+}
+
+int64_t Scrollback::position(Layout & layout, const uint64_t line) const {
+  if (layout.anchor <= line) {
+    return layout.anchor == line ? 0 : layout.below[line - layout.anchor - 1];
+  }
+  for (uint64_t i = layout.above.size(); layout.anchor - line > i; ++i) {
+    layout.above.push_back((layout.above.empty() ? 0 : layout.above.back()) + rows(layout, layout.anchor - 1 - i));
+  }
+  return -static_cast<int64_t>(layout.above[layout.anchor - 1 - line]);
+}
+
+std::pair<uint64_t, uint16_t> Scrollback::locate(const uint64_t index, const uint16_t width) const {
+  assert(size_ >= index);
+  Layout & layout = this->layout(width);
+  const uint64_t line = std::lower_bound(ends_.begin(), ends_.end(), index) - ends_.begin();
+  const uint64_t row = this->row(layout, line, index);
+  const int64_t last = position(layout, ends_.size()) + this->row(layout, ends_.size(), size_);
+  const uint64_t rows = last - (position(layout, line) + static_cast<int64_t>(row));
+
+  const uint64_t start = this->start(layout, line, row);
+  if ( ! has_tabs(line)) {
+    return {rows, index - start + 1};
+  }
+  uint16_t column = 1;
+  for (Iterator iterator(*this, start); index > iterator.index(); ++iterator) {
+    column += L'\t' == (*iterator).character ? 8 - column % 8 : 1;
+  }
+  return {rows, column};
+}
+
+std::pair<uint64_t, uint64_t> Scrollback::rewind(const uint64_t index, const uint64_t n, const uint16_t width) const {
+  assert(size_ >= index);
+  Layout & layout = this->layout(width);
+  const uint64_t line = std::lower_bound(ends_.begin(), ends_.end(), index) - ends_.begin();
+  const int64_t last = position(layout, line) + row(layout, line, index);
+
+  /*
+   * lays out lines above until one holds the first row, or there are none
+   * left, doubling the steps up and halving them back, so rewinding far is
+   * logarithmic in lines once they are laid out.
+   */
+  const auto below = [&](const uint64_t top) { return position(layout, top) > last - static_cast<int64_t>(n); };
+  uint64_t top = line, step = 1;
+  for (; 0 < top && below(top); step *= 2) {
+    top -= std::min(step, top);
+  }
+  /* top is not below the first row, top + step is or is past line */
+  for (uint64_t bottom = std::min(line, top + step); 1 < bottom - top; ) {
+    const uint64_t middle = top + (bottom - top) / 2;
+    (below(middle) ? bottom : top) = middle;
+  }
+  const int64_t first = std::max(last - static_cast<int64_t>(n), position(layout, top));
+  return {start(layout, top, first - position(layout, top)), last - first};
+}
@@ -0,0 +1,278 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <array>
+#include <compare>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chunked.h"
+#include "rune.h"
+#include "spill.h"
+#include "trigram.h"
+
+/*
+ * scrollback as utf-8 text, new lines included, with the attributes kept
+ * apart as runs, one per change rather than one per rune. the byte offset
+ * of every STRIDE-th rune finds any rune by index and the offset of every
+ * new line finds any line, whose text is then a plain copy. runes are only
+ * materialized by the iterators, when read.
+ *
+ * lines are also indexed by the rune ending them and are laid out into rows
+ * lazily, per width. a layout starts from the last line when the width is
+ * first seen, grows down as lines arrive and up only as far as scrolling
+ * back asks for, so a resize costs nothing however long the scrollback.
+ * rows are accumulated from there, finding the rune a row starts at is a
+ * binary search and only lines holding tabs are ever walked. the last two
+ * widths are kept, going back and forth between them lays out nothing.
+ *
+ * the last line stays open while the screen still holds its wrapped rows.
+ * lines with tabs longer than LONG keep where their rows start, walking
+ * only runes not seen yet, so a row deep into a huge line is a binary
+ * search as well.
+ *
+ * text is sealed in blocks of BLOCK bytes, compressed by lz unless that does
+ * not shrink them, and identical blocks share their bytes. blocks are only
+ * decompressed when read, the last HOT of them are kept around so scrolling
+ * through a few screens does not decompress anything twice.
+ *
+ * optionally, once sealed blocks take more than a budget, the oldest ones
+ * spill to a file and are read back through its mapping. past the disk
+ * quota the oldest segments expire, their blocks left blank but for new
+ * lines, so lines and indexes still add up.
+ *
+ * tables growing with the text are chunked, appending never copies them.
+ *
+ * a snapshot copies the list of blocks rather than their bytes, searching
+ * reads it from another thread, decompressing on its own.
+ *
+ * optionally, sealed blocks keep a filter of their trigrams, up to a budget
+ * past which the oldest filters are dropped, for searching to pass over
+ * blocks without decompressing them. blocks also remember their first new
+ * line, where the lines starting in them begin.
+ */
+class Scrollback {
+  struct Run {
+    /* first rune the attributes apply to */
+    uint64_t index = 0;
+    uint32_t attributes = 0;
+  };
+
+  struct Block {
+    /* in memory, shared by identical blocks, until spilled */
+    std::shared_ptr<const std::string> bytes;
+    std::string_view mapped;
+    uint64_t segment = 0;
+    /* of the trigrams from the two bytes before the block on, when indexed */
+    std::shared_ptr<const trigram::Filter> filter;
+    std::size_t newline = std::string::npos;
+    bool compressed = false;
+
+    auto view() const -> std::string_view { return bytes ? std::string_view(*bytes) : mapped; }
+  };
+
+  /* where the rows of a line with tabs start, as far as it was walked */
+  struct Wraps {
+    std::vector<uint64_t> starts;
+    uint64_t walked = 0;
+    uint32_t column = 1;
+  };
+
+  /* rows relative to the first one of the anchor line */
+  struct Layout {
+    uint16_t width = 0;
+    uint64_t anchor = 0;
+    /* rows from the line anchor - 1 - i, included, down to the anchor */
+    Chunked<uint64_t> above;
+    /* rows from the anchor down to the line anchor + i, included */
+    Chunked<uint64_t> below;
+    /* of long lines with tabs */
+    std::unordered_map<uint64_t, Wraps> wraps;
+  };
+
+  /* a window of text, either a block or the tail */
+  struct Chunk {
+    /* keeps a decompressed block alive */
+    std::shared_ptr<const std::string> owner;
+    const char * data = nullptr;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+  };
+
+public:
+  constexpr static uint32_t STRIDE = 64;
+  constexpr static std::size_t BLOCK = 1 << 16;
+  constexpr static std::size_t HOT = 4;
+  constexpr static uint64_t LONG = 1 << 12;
+
+  class Iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = int64_t;
+    using value_type = rune::Rune;
+    using pointer = void;
+    using reference = rune::Rune;
+
+    Iterator() = default;
+
+    auto index() const -> uint64_t { return index_; }
+
+    auto operator * () const -> rune::Rune;
+    auto operator [] (const difference_type n) const -> rune::Rune { return *(*this + n); }
+    auto operator ++ () -> Iterator &;
+    auto operator ++ (int) -> Iterator { Iterator i = *this; ++*this; return i; }
+    auto operator -- () -> Iterator &;
+    auto operator -- (int) -> Iterator { Iterator i = *this; --*this; return i; }
+    auto operator += (const difference_type) -> Iterator &;
+    auto operator -= (const difference_type n) -> Iterator & { return *this += -n; }
+    auto operator + (const difference_type n) const -> Iterator { Iterator i = *this; return i += n; }
+    auto operator - (const difference_type n) const -> Iterator { Iterator i = *this; return i -= n; }
+    auto operator - (const Iterator & o) const -> difference_type { return index_ - o.index_; }
+    auto operator == (const Iterator & o) const -> bool { return index_ == o.index_; }
+    auto operator <=> (const Iterator & o) const -> std::strong_ordering { return index_ <=> o.index_; }
+
+  private:
+    Iterator(const Scrollback &, const uint64_t);
+
+    auto byte(const uint64_t) const -> unsigned char;
+
+    const Scrollback * scrollback_ = nullptr;
+    mutable Chunk chunk_;
+    uint64_t index_ = 0;
+    /* of the rune in the text and of its run */
+    uint64_t offset_ = 0;
+    std::size_t run_ = 0;
+
+    friend class Scrollback;
+  };
+
+  using ReverseIterator = std::reverse_iterator<Iterator>;
+
+  /*
+   * the text as it was, to be read from another thread while the scrollback
+   * goes on. it keeps the spill file open and its segments from expiring.
+   */
+  class Snapshot {
+  public:
+    /* sealed blocks, then the tail */
+    auto blocks() const -> std::size_t { return blocks_.size() + 1; }
+    /* the bytes of a block, valid until the next call */
+    auto block(const std::size_t) -> std::string_view;
+    /* whether blocks first to last, included, may hold every trigram */
+    auto may_match(const std::size_t, const std::size_t, const std::vector<uint32_t> &) const -> bool;
+    /* of the first new line in a block */
+    auto newline(const std::size_t i) const -> std::size_t { return blocks_.size() > i ? blocks_[i].newline : tail_.find('\n'); }
+    auto size() const -> uint64_t { return blocks_.size() * BLOCK + tail_.size(); }
+
+  private:
+    std::vector<Block> blocks_;
+    std::string tail_;
+    std::shared_ptr<spill::File> file_;
+    std::string buffer_;
+
+    friend class Scrollback;
+  };
+
+  auto begin() const -> Iterator { return Iterator(*this, 0); }
+  auto end() const -> Iterator { return Iterator(*this, size_); }
+  auto rbegin() const -> ReverseIterator { return ReverseIterator(end()); }
+  auto rend() const -> ReverseIterator { return ReverseIterator(begin()); }
+
+  auto clear() -> void;
+  auto empty() const -> bool { return 0 == size_; }
+  auto indexed() const -> const trigram::Stats & { return filters_; }
+  /* of the rune at a byte offset of the text */
+  auto index(const uint64_t) const -> uint64_t;
+  /* the text of a line, without its new line */
+  auto line(const uint64_t) const -> std::string;
+  auto lines() const -> uint64_t { return lines_.size(); }
+  /*
+   * rows from the one holding index down to the one holding the end, once
+   * wrapped at width, and the column index is drawn at.
+   */
+  auto locate(const uint64_t index, const uint16_t width) const -> std::pair<uint64_t, uint16_t>;
+  /*
+   * up to n rows before the one holding index, once wrapped at width, fewer
+   * at the top. returns the rune the first of them starts at and how many.
+   */
+  auto rewind(const uint64_t index, const uint64_t n, const uint16_t width) const -> std::pair<uint64_t, uint64_t>;
+  /* bytes allocated for the text, sealed or not, runs and tables */
+  auto memory() const -> std::size_t;
+  auto push_back(const rune::Rune &) -> void;
+  auto size() const -> uint64_t { return size_; }
+  auto snapshot() const -> Snapshot;
+  /* blocks on disk or expired */
+  auto spilled() const -> std::size_t { return spilled_; }
+  /* from now on, blocks over the memory budget go to disk */
+  auto spill(const spill::Options &) -> void;
+  /* from now on, sealed blocks are indexed within a budget of bytes */
+  auto trigrams(const std::size_t) -> void;
+
+private:
+  auto chunk(const uint64_t) const -> Chunk;
+  auto expire() -> void;
+  /* the rune each row of a line holding tabs starts at */
+  auto wraps(Layout &, const uint64_t) const -> const Wraps &;
+  auto begin(const uint64_t line) const -> uint64_t { return 0 == line ? 0 : ends_[line - 1] + 1; }
+  /* of the new line, or of the scrollback for the open line */
+  auto end(const uint64_t line) const -> uint64_t { return ends_.size() > line ? ends_[line] : size_; }
+  auto has_tabs(const uint64_t) const -> bool;
+  /* the layout for width, most recent first */
+  auto layout(const uint16_t) const -> Layout &;
+  /* of the first row of a line relative to the anchor, laying out as much as needed above it */
+  auto position(Layout &, const uint64_t) const -> int64_t;
+  /* rows a line wraps into, the row holding a rune and the rune a row starts at */
+  auto rows(Layout &, const uint64_t) const -> uint64_t;
+  auto row(Layout &, const uint64_t, const uint64_t) const -> uint64_t;
+  auto start(Layout &, const uint64_t, const uint64_t) const -> uint64_t;
+  auto seal() -> void;
+  auto sealed() const -> uint64_t { return blocks_.size() * BLOCK; }
+
+  std::vector<Block> blocks_;
+  /* hash of the bytes of every distinct block to its first index */
+  std::unordered_map<uint64_t, std::size_t> hashes_;
+  /* blocks sharing each bytes in memory, snapshots may hold them as well */
+  std::unordered_map<const std::string *, std::size_t> owners_;
+  /* bytes held in memory by distinct blocks, and by expired ones */
+  std::size_t stored_ = 0;
+  std::size_t blanks_ = 0;
+  /* decompressed blocks by index, most recently read first */
+  mutable std::vector<std::pair<std::size_t, std::shared_ptr<const std::string>>> hot_;
+  std::optional<spill::Options> spill_;
+  /* shared with snapshots */
+  std::shared_ptr<spill::File> file_;
+  /* blocks before these are on disk and expired */
+  std::size_t spilled_ = 0;
+  std::size_t expired_ = 0;
+  /* bytes for filters, none when 0, and blocks before the first one filtered */
+  std::size_t trigrams_ = 0;
+  std::size_t unfiltered_ = 0;
+  trigram::Stats filters_;
+  /* of the last block sealed, for trigrams across blocks */
+  char last_[2] = {};
+  /* text not sealed yet */
+  std::string tail_;
+  Chunked<Run> runs_;
+  /* byte offset of every STRIDE-th rune */
+  Chunked<uint64_t> offsets_;
+  /* byte offset of the new line ending every line */
+  Chunked<uint64_t> lines_;
+  /* index of the new line ending every line */
+  Chunked<uint64_t> ends_;
+  /* lines with tabs, which take more columns than runes */
+  Chunked<uint64_t> tabs_;
+  mutable std::array<Layout, 2> layouts_;
+  /* wraps of short lines, not worth keeping */
+  mutable Wraps scratch_;
+  uint64_t size_ = 0;
+};
@@ -0,0 +1,266 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+#include <chrono>
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "cpu.h"
+#include "search.h"
+#include "trigram.h"
+
+using namespace std::chrono_literals;
+
+namespace search {
+
+namespace {
+
+/* the first and last bytes of a pattern, or'ed with 0x20 when they are letters to fold */
+struct Needle {
+  std::size_t size = 0;
+  unsigned char first = 0;
+  unsigned char last = 0;
+  unsigned char first_fold = 0;
+  unsigned char last_fold = 0;
+};
+
+using Scan = std::size_t (*)(const unsigned char * const, const std::size_t, const Needle &);
+
+constexpr unsigned char lower(const unsigned char c) {
+  return 'A' <= c && 'Z' >= c ? c | 0x20 : c;
+}
+
+constexpr unsigned char fold(const unsigned char c, const bool folding) {
+  return folding && 'a' <= lower(c) && 'z' >= lower(c) ? 0x20 : 0;
+}
+
+/* scalar fallback, starts is how many positions a match may start at */
+
+std::size_t scan_scalar(const unsigned char * const text, const std::size_t starts, const Needle & needle) {
+  std::size_t i = 0;
+  for (; starts > i; ++i) {
+    if (needle.first == (text[i] | needle.first_fold)
+        && needle.last == (text[i + needle.size - 1] | needle.last_fold)) {
+      break;
+    }
+  }
+  return i;
+}
+
+#if defined(__SSE2__)
+std::size_t scan_sse2(const unsigned char * const text, const std::size_t starts, const Needle & needle) {
+  const __m128i first = _mm_set1_epi8(needle.first);
+  const __m128i last = _mm_set1_epi8(needle.last);
+  const __m128i first_fold = _mm_set1_epi8(needle.first_fold);
+  const __m128i last_fold = _mm_set1_epi8(needle.last_fold);
+  std::size_t i = 0;
+  for (; starts >= i + 16; i += 16) {
+    const __m128i a = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i)), first_fold);
+    const __m128i b = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + needle.size - 1)), last_fold);
+    const int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+    if (0 != mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + scan_scalar(text + i, starts - i, needle);
+}
+
+__attribute__((target("avx2")))
+std::size_t scan_avx2(const unsigned char * const text, const std::size_t starts, const Needle & needle) {
+  const __m256i first = _mm256_set1_epi8(needle.first);
+  const __m256i last = _mm256_set1_epi8(needle.last);
+  const __m256i first_fold = _mm256_set1_epi8(needle.first_fold);
+  const __m256i last_fold = _mm256_set1_epi8(needle.last_fold);
+  std::size_t i = 0;
+  for (; starts >= i + 32; i += 32) {
+    const __m256i a = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i)), first_fold);
+    const __m256i b = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + needle.size - 1)), last_fold);
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+    if (0 != mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + scan_sse2(text + i, starts - i, needle);
+}
+#endif /* __SSE2__ */
+
+const struct Implementation {
+  Scan scan = scan_scalar;
+
+  Implementation() {
+#if defined(__SSE2__)
+    scan = cpu::Level::AVX2 == cpu::level() ? scan_avx2 : scan_sse2;
+#endif
+  }
+} implementation;
+
+} // end of annonymous namespace
+
+bool smart_case(const std::string_view pattern) {
+  return std::none_of(pattern.begin(), pattern.end(), [](const char c) { return 'A' <= c && 'Z' >= c; });
+}
+
+Matcher::Matcher(const Query & query) : query_(query) {
+  if (query_.pattern.empty()) {
+    return;
+  }
+  if (query_.regex) {
+    auto flags = std::regex::ECMAScript | std::regex::optimize;
+    if (query_.fold) {
+      flags |= std::regex::icase;
+    }
+    try {
+      regex_.emplace(query_.pattern, flags);
+    } catch (const std::regex_error &) {
+      /* incomplete while typing, nothing matches */
+    }
+    return;
+  }
+  needle_ = query_.pattern;
+  if (query_.fold) {
+    std::transform(needle_.begin(), needle_.end(), needle_.begin(), lower);
+  }
+  trigrams_ = trigram::of(needle_);
+}
+
+void Matcher::find(const std::string_view text, const uint64_t base, std::vector<Match> & matches) const {
+  if ( ! valid()) {
+    return;
+  }
+  if ( ! query_.regex) {
+    substrings(text, base, matches);
+    return;
+  }
+  for (std::size_t begin = 0; text.size() > begin; ) {
+    const std::size_t end = std::min(text.find('\n', begin), text.size());
+    const std::cregex_iterator END;
+    for (std::cregex_iterator iterator(text.data() + begin, text.data() + end, *regex_); END != iterator; ++iterator) {
+      if (0 < iterator->length()) {
+        matches.push_back(Match{
+          .offset = base + begin + iterator->position(),
+          .size = static_cast<uint32_t>(iterator->length()), });
+      }
+    }
+    begin = end + 1;
+  }
+}
+
+void Matcher::substrings(const std::string_view text, const uint64_t base, std::vector<Match> & matches) const {
+  const std::size_t size = needle_.size();
+  if (text.size() < size) {
+    return;
+  }
+  const unsigned char * const bytes = reinterpret_cast<const unsigned char *>(text.data());
+  const unsigned char * const pattern = reinterpret_cast<const unsigned char *>(needle_.data());
+  const Needle needle{
+    .size = size,
+    .first = pattern[0],
+    .last = pattern[size - 1],
+    .first_fold = fold(pattern[0], query_.fold),
+    .last_fold = fold(pattern[size - 1], query_.fold),
+  };
+  const auto equal = [&](const unsigned char * const candidate) {
+    if ( ! query_.fold) {
+      return 0 == std::memcmp(candidate, pattern, size);
+    }
+    for (std::size_t i = 0; size > i; ++i) {
+      if (pattern[i] != lower(candidate[i])) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const std::size_t starts = text.size() - size + 1;
+  for (std::size_t i = 0; starts > i; ) {
+    i += implementation.scan(bytes + i, starts - i, needle);
+    if (starts <= i) {
+      break;
+    }
+    if (equal(bytes + i)) {
+      matches.push_back(Match{ .offset = base + i, .size = static_cast<uint32_t>(size), });
+      i += size;
+    } else {
+      ++i;
+    }
+  }
+}
+
+Search::~Search() {
+  running_.store(false, std::memory_order_release);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+Search::Search(Scrollback::Snapshot && snapshot, const Query & query) :
+  snapshot_(std::move(snapshot)), matcher_(query) {
+  thread_ = std::thread(&Search::run, this);
+}
+
+/* waits for a free slot while the screen has not drained the queue */
+bool Search::emit(const Match & match) {
+  for (uint32_t attempt = 0; ; ++attempt) {
+    Match * const slot = queue_.back();
+    if (nullptr != slot) {
+      *slot = match;
+      queue_.push();
+      return true;
+    }
+    if ( ! running_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (64 > attempt) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(100us);
+    }
+  }
+}
+
+/*
+ * block by block from the end. a block searches the lines starting in it,
+ * the first one started before unless it is the first block, and the last
+ * one is read on into the next blocks up to its new line. blocks are only
+ * read when their filters may hold the pattern.
+ */
+void Search::run() {
+  const std::size_t blocks = matcher_.valid() ? snapshot_.blocks() : 0;
+  for (std::size_t i = blocks; 0 < i-- && running_.load(std::memory_order_relaxed); ) {
+    std::size_t skip = 0;
+    if (0 < i) {
+      skip = snapshot_.newline(i);
+      if (std::string::npos == skip) {
+        continue;
+      }
+      ++skip;
+    }
+    std::size_t last = i + 1;
+    for (; blocks > last && std::string::npos == snapshot_.newline(last); ++last) { }
+    if ( ! snapshot_.may_match(i, std::min(last, blocks - 1), matcher_.trigrams())) {
+      continue;
+    }
+
+    chunk_.assign(snapshot_.block(i));
+    for (std::size_t j = i + 1; blocks > j && last >= j; ++j) {
+      const std::string_view next = snapshot_.block(j);
+      chunk_.append(next.substr(0, last == j ? snapshot_.newline(j) : std::string_view::npos));
+    }
+
+    matches_.clear();
+    matcher_.find(std::string_view(chunk_).substr(skip), i * Scrollback::BLOCK + skip, matches_);
+    for (auto iterator = matches_.rbegin(); matches_.rend() != iterator; ++iterator) {
+      if ( ! emit(*iterator)) {
+        break;
+      }
+    }
+  }
+  done_.store(true, std::memory_order_release);
+}
+
+} // end of namespace search
@@ -0,0 +1,103 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+#include "queue.h"
+#include "scrollback.h"
+
+/*
+ * Incremental search through scrollback.
+ *
+ * A `Search` scans a snapshot of the scrollback on its own thread, from the
+ * last block back to the first, and streams byte offsets of matches newest
+ * first, so the closest hit shows up before anything older is even read.
+ * Lines running across blocks are completed from the blocks after them,
+ * every line is searched once and whole.
+ *
+ * Substrings are found through a prefilter comparing the first and the last
+ * byte of the pattern 16 or 32 positions at a time when sse2 or avx2 are
+ * available, candidates are then compared in full. Regular expressions are
+ * ECMAScript, matched line by line. Case folding is ascii only.
+ *
+ * When scrollback is indexed, blocks whose filters miss a trigram of the
+ * pattern are passed over without being read.
+ */
+namespace search {
+
+struct Query {
+  std::string pattern;
+  bool regex = false;
+  bool fold = false;
+};
+
+/* in bytes of the scrollback text */
+struct Match {
+  uint64_t offset = 0;
+  uint32_t size = 0;
+};
+
+/* folds case unless the pattern has upper case letters */
+auto smart_case(const std::string_view) -> bool;
+
+class Matcher {
+public:
+  explicit Matcher(const Query &);
+
+  /* false for a regular expression which does not compile */
+  auto valid() const -> bool { return query_.regex ? regex_.has_value() : ! needle_.empty(); }
+  /* appends the matches in text, in order and not overlapping, offset by base */
+  auto find(const std::string_view, const uint64_t, std::vector<Match> &) const -> void;
+  /* hashes of the trigrams any match holds, none for regular expressions */
+  auto trigrams() const -> const std::vector<uint32_t> & { return trigrams_; }
+
+private:
+  auto substrings(const std::string_view, const uint64_t, std::vector<Match> &) const -> void;
+
+  Query query_;
+  /* folded when folding */
+  std::string needle_;
+  std::optional<std::regex> regex_;
+  std::vector<uint32_t> trigrams_;
+};
+
+class Search {
+public:
+  using Queue = SPSCQueue<Match, 1024>;
+
+  ~Search();
+  Search(Scrollback::Snapshot &&, const Query &);
+
+  Search(const Search &) = delete;
+  Search & operator = (const Search &) = delete;
+
+  /* every match was pushed */
+  auto done() const -> bool { return done_.load(std::memory_order_acquire); }
+  auto queue() -> Queue & { return queue_; }
+  auto valid() const -> bool { return matcher_.valid(); }
+
+private:
+  auto emit(const Match &) -> bool;
+  auto run() -> void;
+
+  Queue queue_;
+  Scrollback::Snapshot snapshot_;
+  const Matcher matcher_;
+  /* the lines being searched and their matches */
+  std::string chunk_;
+  std::vector<Match> matches_;
+  std::atomic_bool done_ = false;
+  std::atomic_bool running_ = true;
+  std::thread thread_;
+};
+
+} // end of namespace search
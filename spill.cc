@@ -0,0 +1,81 @@
+// Copyright Daniel Morilha 2025
+
+#include <iostream>
+
+#include <cassert>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "spill.h"
+
+namespace spill {
+
+File::~File() {
+  clear();
+  if (0 <= fd_) {
+    close(fd_);
+  }
+}
+
+bool File::open(const std::string & directory) {
+  assert(0 > fd_);
+  fd_ = directory.empty()
+    ? memfd_create("scrollback", MFD_CLOEXEC)
+    : ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+  if (0 > fd_) {
+    std::cerr << "failed to create a file for scrollback in "
+      << (directory.empty() ? "memory" : directory) << ", it stays in memory" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void File::clear() {
+  for (char * const segment : segments_) {
+    munmap(segment, SEGMENT);
+  }
+  first_ += segments_.size();
+  segments_.clear();
+  used_ = 0;
+  if (0 <= fd_) {
+    ftruncate(fd_, 0);
+  }
+}
+
+void File::expire() {
+  assert( ! segments_.empty());
+  munmap(segments_.front(), SEGMENT);
+  /* the file keeps its size, holes take no space */
+  fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, first_ * SEGMENT, SEGMENT);
+  segments_.pop_front();
+  ++first_;
+}
+
+File::Extent File::write(const std::string_view bytes) {
+  assert(SEGMENT >= bytes.size());
+  if (0 > fd_) {
+    return {};
+  }
+  if (segments_.empty() || SEGMENT < used_ + bytes.size()) {
+    const uint64_t segment = first_ + segments_.size();
+    /* allocated upfront, a full disk fails here rather than as a SIGBUS later */
+    if (0 != fallocate(fd_, 0, segment * SEGMENT, SEGMENT)) {
+      return {};
+    }
+    void * const data = mmap(nullptr, SEGMENT, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, segment * SEGMENT);
+    if (MAP_FAILED == data) {
+      return {};
+    }
+    segments_.push_back(static_cast<char *>(data));
+    used_ = 0;
+  }
+  char * const data = segments_.back() + used_;
+  memcpy(data, bytes.data(), bytes.size());
+  used_ += bytes.size();
+  return Extent{ .bytes = std::string_view(data, bytes.size()), .segment = first_ + segments_.size() - 1, };
+}
+
+} // end of namespace spill
@@ -0,0 +1,68 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * sealed scrollback moved out of the heap into an unlinked temporary file,
+ * or a memfd when no directory is given, mapped in segments of SEGMENT
+ * bytes. written pages belong to the page cache, which decides how many of
+ * them stay resident. expiring the oldest segment unmaps it and punches a
+ * hole in its place, so a quota bounds the disk used while offsets into the
+ * file keep growing.
+ */
+namespace spill {
+
+struct Options {
+  /* bytes of sealed scrollback kept in memory, older blocks go to disk */
+  std::size_t memory = 64 << 20;
+  /* bytes on disk before the oldest segments expire, 0 keeps everything */
+  std::size_t disk = 0;
+  /* where the file is created, a memfd when empty */
+  std::string directory;
+};
+
+class File {
+public:
+  constexpr static std::size_t SEGMENT = 16 << 20;
+
+  /* where some bytes were written */
+  struct Extent {
+    std::string_view bytes;
+    uint64_t segment = 0;
+  };
+
+  ~File();
+  File() = default;
+
+  File(const File &) = delete;
+  File & operator = (const File &) = delete;
+
+  auto clear() -> void;
+  /* unmaps the oldest segment and releases its disk space */
+  auto expire() -> void;
+  /* the oldest segment not expired */
+  auto first() const -> uint64_t { return first_; }
+  auto open(const std::string &) -> bool;
+  /* bytes on disk */
+  auto size() const -> std::size_t { return segments_.size() * SEGMENT; }
+  auto segments() const -> std::size_t { return segments_.size(); }
+  /* copies up to SEGMENT bytes, an empty extent when the file can not grow */
+  auto write(const std::string_view) -> Extent;
+
+private:
+  int fd_ = -1;
+  /* mappings of the segments not expired, the first one is first_ */
+  std::deque<char *> segments_;
+  uint64_t first_ = 0;
+  /* bytes used in the last segment */
+  std::size_t used_ = 0;
+};
+
+} // end of namespace spill
@@ -7,10 +7,11 @@
 #include <vector>
 
 #include <cassert>
-#include <cwchar>
+#include <cstring>
 
 #include <fcntl.h>
 #include <pty.h>
+#include <sys/ioctl.h>
 #include <termios.h>
 #include <utmp.h>
 
@@ -24,81 +25,102 @@ const std::string Terminal::path = "/bin/bash";
 
 Terminal::Terminal(Screen & screen) : Events(POLLIN | POLLHUP), screen_(screen) { }
 
-bool Terminal::pollin(const std::optional<TimePoint> &) {
-  ssize_t length = 0;
-  {
-    const ssize_t result = read(fd_.child, buffer_.data() + bufferStart_, buffer_.size() - bufferStart_);
+bool Terminal::pollin(const std::optional<TimePoint> & t) {
+  Slice slice(budget, t);
+  while ( ! backlogged()) {
+    const ssize_t result = buffer_.read(fd_.child);
     if (0 > result) {
       if (EAGAIN == errno) {
-        return true;
+        break;
       } else {
         assert(!"ERROR");
-      }
-    }
-    length = bufferStart_ + result;
-  }
-  while (bufferStart_ < length) {
-    uint16_t iterator = 0;
-    while (length > iterator) {
-      wchar_t character;
-      const size_t size = length - iterator;
-      const ssize_t bytes = mbrtowc(&character, &buffer_[iterator], size, nullptr);
-      assert(4 >= bytes);
-      assert(bytes <= size);
-#if DEBUG
-      std::array<char, 5> display{'\0'};
-      strncpy(display.data(), static_cast<const char *>(&buffer_[iterator]), bytes);
-      std::cout << __func__ << ": " << iterator << ", " << bufferStart_ << ", " << length << ", " << size << ", " << bytes << " " << display.data() << std::endl;
-#endif //DEBUG
-      switch (bytes) {
-      case -2: /* INCOMPLETE */
-        return true;
-        if (0 < iterator) {
-          strncpy(&buffer_[0], &buffer_[iterator], size);
-        }
-        bufferStart_ = iterator = size;
-        assert(4 > bufferStart_);
-        break;
-      case -1: /* INVALID */
-        std::cout << "INVALID " << iterator << ", " << bufferStart_ << ", " << length << ", " << size << ", " << bytes << std::endl;
-        assert(!"INVALID");
-        break;
-      case 0: /* ODD */
-        bufferStart_ = 0;
-        break;
-      default:
-        screen_.pushBack(rune::Rune{character});
-        iterator += bytes;
-        bufferStart_ = 0;
         break;
       }
+    } else if (0 == result) {
+      pollhup();
+      break;
     }
-
-    {
-      const ssize_t result = read(fd_.child, buffer_.data() + bufferStart_, buffer_.size() - bufferStart_);
-      if (0 > result) {
-        if (EAGAIN == errno) {
-          break;
-        } else {
-          assert(!"ERROR");
+    if (recorder_) {
+      assert(buffer_.front().size() == static_cast<std::size_t>(result));
+      recorder_->write(buffer_.front().data(), result);
+    }
+    while ( ! buffer_.empty()) {
+      const std::span<const char> input = buffer_.front().first(
+          std::min(buffer_.front().size(), characters_.size() - 1));
+      /* incomplete sequences are carried over by the decoder */
+      const std::size_t length = decoder_.decode(input.data(), input.size(), characters_.data());
+      assert(characters_.size() >= length);
+      for (std::size_t i = 0; length > i; ++i) {
+        if (L'\0' != characters_[i]) {
+          screen_.pushBack(rune::Rune{characters_[i]});
         }
       }
-      length = bufferStart_ + result;
+      buffer_.consume(input.size());
+    }
+    slice.bytes += result;
+    if (slice.expire()) {
+      return false;
     }
-
   }
   return true;
 }
 
+/*
+ * backpressure, once backlog bytes were read since the last render the
+ * child is no longer polled, the kernel holds whatever else it writes and
+ * eventually blocks it, until the timers run again.
+ */
+void Terminal::prepare() {
+  if (nullptr != budget && renders_ != budget->stats().renders) {
+    renders_ = budget->stats().renders;
+    drained_ = reads().bytes;
+    drained();
+  }
+  events = backlogged() ? 0 : POLLIN | POLLHUP;
+}
+
+bool Terminal::backlogged() const {
+  return 0 < backlog_ && drained_ + backlog_ <= reads().bytes;
+}
+
 void Terminal::pollhup() {
-  exit(0);
+  if (backlogged()) {
+    /* there may be output left, hangs up once it is read */
+    return;
+  }
+  if (static_cast<bool>(onHangup)) {
+    onHangup();
+  } else {
+    exit(0);
+  }
 }
 
 int Terminal::childfd() const {
   return fd_.child;
 }
 
-std::unique_ptr<Terminal> Terminal::New(Screen & screen) {
+void Terminal::setup(const Options & options) {
+  fcntl(fd_.child, F_SETFL, fcntl(fd_.child, F_GETFL) | O_NONBLOCK);
+  buffer_.limit(options.buffer);
+  backlog_ = options.backlog;
+  if ( ! options.record.empty()) {
+    recorder_ = std::make_unique<recording::Writer>(options.record);
+  }
+  if (options.threaded) {
+    thread();
+  }
+}
+
+std::unique_ptr<Terminal> Terminal::Replay(Screen & screen, const int fd, const Options & options) {
+  std::unique_ptr<Terminal> instance(new vt100(screen));
+  instance->winsize_.ws_col = screen.columns();
+  instance->winsize_.ws_row = screen.lines();
+  instance->fd_.child = fd;
+  instance->setup(options);
+  return instance;
+}
+
+std::unique_ptr<Terminal> Terminal::New(Screen & screen, const Options & options) {
   static char * arguments[] = { nullptr, };
   std::unique_ptr<Terminal> instance = nullptr;
 
@@ -147,7 +169,7 @@ std::unique_ptr<Terminal> Terminal::New(Screen & screen) {
     std::cerr << "failed to fork process" << std::endl;
   }
   close(instance->fd_.parent);
-  fcntl(instance->fd_.child, F_SETFL, fcntl(instance->fd_.child, F_GETFL) | O_NONBLOCK);
+  instance->setup(options);
   return instance;
 }
 
@@ -163,6 +185,9 @@ void Terminal::resize(int32_t, int32_t) {
     winsize_.ws_col = screen_.columns();
     winsize_.ws_row = screen_.lines();
     assert(0 < fd_.child);
+    if (0 == pid_) {
+      return; /* replaying, there is no pty */
+    }
     const int result = ioctl(fd_.child, TIOCSWINSZ, &winsize_);
     assert(0 == result);
   }
@@ -9,21 +9,45 @@
 #include <pty.h>
 
 #include "poller.h"
+#include "recording.h"
+#include "ring.h"
+#include "utf8.h"
 
 struct Screen;
 
 struct Terminal : public Events {
-  static std::unique_ptr<Terminal> New(Screen &);
+  struct Options {
+    /* reads and parses on a separate thread */
+    bool threaded = false;
+    /* tees everything read from the child into a recording */
+    std::string record;
+    /* upper bound the read buffer may grow to */
+    std::size_t buffer = ReadBuffer::MAXIMUM;
+    /* bytes read in between renders before the child is throttled, 0 never throttles */
+    std::size_t backlog = 4 << 20;
+  };
+
+  static std::unique_ptr<Terminal> New(Screen &, const Options &);
+  /* a terminal reading from fd instead of a child, for replaying recordings */
+  static std::unique_ptr<Terminal> Replay(Screen &, const int, const Options &);
 
   int childfd() const;
+  /* the file descriptor to poll on, either the child's or a worker's */
+  virtual int pollfd() const { return fd_.child; }
+  /* how the child's output has been read so far */
+  virtual ReadBuffer::Stats reads() const { return buffer_.stats(); }
 
   void pollhup() override;
   bool pollin(const std::optional<TimePoint> &) override;
+  void prepare() override;
   void resize(int32_t, int32_t);
 
   void write(const char * const, const size_t);
   void write(const std::string & s) { write(s.c_str(), s.size()); }
 
+  /* called once the child is gone, exits by default */
+  std::function<void ()> onHangup;
+
   template <typename ... Args>
   void escape(const char * const format, Args ... args) {
     std::array<char, 1024> escape_sequence{'\0',};
@@ -34,6 +58,13 @@ struct Terminal : public Events {
 
 protected:
   Terminal(Screen &);
+  /* moves reading and parsing the child's output to a thread, if supported */
+  virtual void thread() { }
+  /* called once everything read so far went through a render */
+  virtual void drained() { }
+  /* whether reading should wait for the next render */
+  bool backlogged() const;
+  void setup(const Options &);
   const static std::string path;
   Screen & screen_;
   struct winsize winsize_{
@@ -45,6 +76,12 @@ protected:
     int parent = 0;
   } fd_;
   pid_t pid_ = 0;
-  std::array<char, 4096> buffer_;
-  uint16_t bufferStart_ = 0;
+  ReadBuffer buffer_;
+  std::array<wchar_t, 4096 + 1> characters_;
+  utf8::Decoder decoder_;
+  std::unique_ptr<recording::Writer> recorder_;
+  /* backpressure */
+  std::size_t backlog_ = 0;
+  uint64_t drained_ = 0;
+  uint64_t renders_ = 0;
 };
@@ -0,0 +1,85 @@
+// Copyright Daniel Morilha 2025
+
+#include <iostream>
+#include <string>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "lz.h"
+
+/*
+ * round trips blocks the size scrollback seals through the codec: text it
+ * can not shrink, matches whose lengths cross the 15 and 15 + 255 encoding
+ * boundaries and matches overlapping the bytes they copy.
+ */
+namespace {
+
+/* as sealed by scrollback */
+constexpr std::size_t BLOCK = 1 << 16;
+
+struct Random {
+  auto bytes(const std::size_t size) -> std::string {
+    std::string result(size, '\0');
+    for (char & c : result) {
+      seed = seed * 6364136223846793005 + 1442695040888963407;
+      c = static_cast<char>(seed >> 56);
+    }
+    return result;
+  }
+
+  uint64_t seed = 0;
+};
+
+/* the text comes back as it was, compressed to at most limit bytes */
+auto check(const char * const name, const std::string & text, const std::size_t limit = SIZE_MAX) -> bool {
+  const std::string compressed = lz::compress(text);
+  if (lz::decompress(compressed, text.size()) != text) {
+    std::cerr << name << ": " << text.size() << " bytes do not round trip" << std::endl;
+    return false;
+  }
+  if (limit < compressed.size()) {
+    std::cerr << name << ": " << text.size() << " bytes compressed to "
+      << compressed.size() << ", " << limit << " expected at most" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+} // end of annonymous namespace
+
+int main() {
+  Random random;
+  bool success = true;
+
+  success &= check("empty", "");
+  success &= check("shorter than a match", "abc");
+  /* literals only, their length bytes are all the overhead */
+  success &= check("incompressible", random.bytes(BLOCK), BLOCK + 1 + BLOCK / 255 + 1);
+
+  /*
+   * match lengths around where the token and each extra length byte
+   * saturate, the match may start a few bytes late when the hash table
+   * forgot the first copy, but most of it is taken.
+   */
+  for (const std::size_t size : {4, 18, 19, 20, 30, 269, 270, 271, 273, 274, 275, 524, 529, 530, 1000, 20000}) {
+    const std::string repeated = random.bytes(size);
+    std::string text = random.bytes(BLOCK / 2 - size);
+    text += repeated + random.bytes(64) + repeated;
+    text += random.bytes(BLOCK - text.size());
+    success &= check(("match of " + std::to_string(size)).c_str(), text, BLOCK + BLOCK / 255 + 16 - size / 2);
+  }
+
+  /* offsets shorter than the match, down to a single repeated byte */
+  for (const std::size_t period : {1, 2, 3, 7, 64, 300}) {
+    const std::string pattern = random.bytes(period);
+    std::string text;
+    while (BLOCK > text.size()) {
+      text += pattern;
+    }
+    text.resize(BLOCK);
+    success &= check(("period of " + std::to_string(period)).c_str(), text, period + BLOCK / 255 + 16);
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
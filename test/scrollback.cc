@@ -0,0 +1,59 @@
+// Copyright Daniel Morilha 2025
+
+#include <iostream>
+
+#include <cstdlib>
+
+#include "scrollback.h"
+
+/*
+ * blocks spilling while a snapshot holds them still leave the memory
+ * budget, two scrollbacks fed the same text end up the same whether or not
+ * one of them was searched along the way.
+ */
+namespace {
+
+constexpr std::size_t BLOCKS = 4;
+
+/* one block of text lz can not shrink, different every time */
+auto fill(Scrollback & scrollback, uint64_t & seed) -> void {
+  for (std::size_t i = 0; Scrollback::BLOCK > i; ++i) {
+    seed = seed * 6364136223846793005 + 1442695040888963407;
+    scrollback.push_back(rune::Rune(0 == (i + 1) % 80 ? L'\n' : L'!' + (seed >> 33) % 94));
+  }
+}
+
+} // end of annonymous namespace
+
+int main() {
+  spill::Options options;
+  options.memory = BLOCKS * Scrollback::BLOCK;
+  Scrollback plain, searched;
+  plain.spill(options);
+  searched.spill(options);
+
+  uint64_t a = 0, b = 0;
+  for (std::size_t i = 0; BLOCKS > i; ++i) {
+    fill(plain, a);
+    fill(searched, b);
+  }
+  {
+    const Scrollback::Snapshot snapshot = searched.snapshot();
+    for (std::size_t i = 0; 16 > i; ++i) {
+      fill(plain, a);
+      fill(searched, b);
+    }
+  }
+  for (std::size_t i = 0; 64 > i; ++i) {
+    fill(plain, a);
+    fill(searched, b);
+  }
+
+  if (plain.spilled() != searched.spilled() || plain.memory() != searched.memory()) {
+    std::cerr << "spilling under a snapshot: " << searched.spilled() << " blocks spilled in "
+      << searched.memory() << " bytes, " << plain.spilled() << " in " << plain.memory()
+      << " expected" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
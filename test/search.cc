@@ -0,0 +1,141 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "scrollback.h"
+#include "search.h"
+
+/*
+ * searches scrollback for substrings and compares what comes out with
+ * std::string::find over the same text, line by line and left to right,
+ * with trigram filters, with sealed blocks spilled and with case folded.
+ */
+namespace {
+
+constexpr std::size_t BLOCKS = 24;
+
+struct Configuration {
+  const char * name = "";
+  bool trigrams = false;
+  bool spill = false;
+};
+
+constexpr char lower(const char c) {
+  return 'A' <= c && 'Z' >= c ? c | 0x20 : c;
+}
+
+/*
+ * short lines of few letters, so patterns match often and overlap
+ * themselves, a few lines longer than a block and a rare word, in
+ * different cases, which most blocks do not hold.
+ */
+auto text() -> std::string {
+  std::string result;
+  uint64_t seed = 0;
+  const auto next = [&seed](const uint64_t n) {
+    seed = seed * 6364136223846793005 + 1442695040888963407;
+    return (seed >> 33) % n;
+  };
+  for (std::size_t line = 0; BLOCKS * Scrollback::BLOCK > result.size(); ++line) {
+    const std::size_t size = 0 == line % 997 ? Scrollback::BLOCK + next(Scrollback::BLOCK) : next(120);
+    for (std::size_t i = 0; size > i; ++i) {
+      result.push_back("aabAB c"[next(7)]);
+    }
+    if (0 == line % 2003) {
+      result.insert(result.size() - size / 2, 0 == line % 3 ? "NeedLe" : "needle");
+    }
+    result.push_back('\n');
+  }
+  /* the open line */
+  result.append("aab needle");
+  return result;
+}
+
+auto expected(const std::string & text, const std::string & pattern, const bool fold) -> std::vector<uint64_t> {
+  std::string haystack = text, needle = pattern;
+  if (fold) {
+    std::transform(haystack.begin(), haystack.end(), haystack.begin(), lower);
+    std::transform(needle.begin(), needle.end(), needle.begin(), lower);
+  }
+  std::vector<uint64_t> offsets;
+  for (std::size_t begin = 0; haystack.size() > begin; ) {
+    const std::size_t end = std::min(haystack.find('\n', begin), haystack.size());
+    const std::string line = haystack.substr(begin, end - begin);
+    for (std::size_t i = line.find(needle); std::string::npos != i; i = line.find(needle, i + needle.size())) {
+      offsets.push_back(begin + i);
+    }
+    begin = end + 1;
+  }
+  return offsets;
+}
+
+/* drains the search until it is done, newest match first */
+auto found(const Scrollback & scrollback, const search::Query & query) -> std::vector<uint64_t> {
+  search::Search search(scrollback.snapshot(), query);
+  std::vector<uint64_t> offsets;
+  while (true) {
+    const bool done = search.done();
+    while (const search::Match * const match = search.queue().front()) {
+      offsets.push_back(match->offset);
+      search.queue().pop();
+    }
+    if (done) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  std::reverse(offsets.begin(), offsets.end());
+  return offsets;
+}
+
+} // end of annonymous namespace
+
+int main() {
+  const std::string all = text();
+  bool success = true;
+
+  for (const Configuration & configuration : {
+      Configuration{ .name = "plain", },
+      Configuration{ .name = "trigrams", .trigrams = true, },
+      Configuration{ .name = "spill", .spill = true, },
+      Configuration{ .name = "trigrams and spill", .trigrams = true, .spill = true, }, }) {
+    Scrollback scrollback;
+    if (configuration.trigrams) {
+      scrollback.trigrams(64 << 20);
+    }
+    if (configuration.spill) {
+      spill::Options options;
+      options.memory = 4 * Scrollback::BLOCK;
+      scrollback.spill(options);
+    }
+    for (const char c : all) {
+      scrollback.push_back(rune::Rune(static_cast<wchar_t>(c)));
+    }
+
+    for (const char * const pattern : { "a", "aa", "aab", "AB", "b c", "needle", "NeedLe", "eDl", "missing", }) {
+      for (const bool fold : { false, true, }) {
+        const std::vector<uint64_t> wanted = expected(all, pattern, fold);
+        const std::vector<uint64_t> got = found(scrollback, search::Query{ .pattern = pattern, .fold = fold, });
+        if (wanted != got) {
+          std::cerr << configuration.name << ": \"" << pattern << "\"" << (fold ? " folded" : "")
+            << " found " << got.size() << " matches, " << wanted.size() << " expected";
+          const auto mismatch = std::mismatch(wanted.begin(), wanted.end(), got.begin(), got.end());
+          if (wanted.end() != mismatch.first) {
+            std::cerr << ", first missing at " << *mismatch.first;
+          }
+          std::cerr << std::endl;
+          success = false;
+        }
+      }
+    }
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
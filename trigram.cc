@@ -0,0 +1,54 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+
+#include "trigram.h"
+
+namespace trigram {
+
+namespace {
+
+constexpr unsigned char lower(const unsigned char c) {
+  return 'A' <= c && 'Z' >= c ? c | 0x20 : c;
+}
+
+} // end of annonymous namespace
+
+uint32_t hash(const unsigned char a, const unsigned char b, const unsigned char c) {
+  const uint32_t trigram = lower(a) << 16 | lower(b) << 8 | lower(c);
+  return (trigram * 0x9e3779b1u) >> 16;
+}
+
+std::vector<uint32_t> of(const std::string_view pattern) {
+  std::vector<uint32_t> hashes;
+  const unsigned char * const bytes = reinterpret_cast<const unsigned char *>(pattern.data());
+  for (std::size_t i = 0; pattern.size() >= i + 3; ++i) {
+    hashes.push_back(hash(bytes[i], bytes[i + 1], bytes[i + 2]));
+  }
+  std::sort(hashes.begin(), hashes.end());
+  hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+  return hashes;
+}
+
+void Filter::add(const std::string_view carry, const std::string_view text) {
+  static_assert(1 << 16 == BITS, "hashes take 16 bits");
+  const unsigned char * const bytes = reinterpret_cast<const unsigned char *>(text.data());
+  unsigned char a = 1 < carry.size() ? carry[carry.size() - 2] : 0;
+  unsigned char b = 0 < carry.size() ? carry.back() : 0;
+  for (std::size_t i = 0; text.size() > i; ++i) {
+    const unsigned char c = bytes[i];
+    if (0 != a) {
+      const uint32_t h = hash(a, b, c);
+      bits[h / 64] |= uint64_t{1} << h % 64;
+    }
+    a = b;
+    b = c;
+  }
+}
+
+std::ostream & operator << (std::ostream & o, const Stats & s) {
+  o << s.blocks << " blocks indexed, " << (s.bytes >> 10) << " KiB";
+  return o;
+}
+
+} // end of namespace trigram
@@ -0,0 +1,44 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <array>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * trigrams of scrollback text, folded to lower case ascii, hashed into a
+ * bitmap of BITS per sealed block. a block holds every trigram of a pattern
+ * only if all of their bits are set, so searching reads no block missing
+ * any of them. bits collide, which only costs reading a block for nothing.
+ */
+namespace trigram {
+
+constexpr std::size_t BITS = 1 << 16;
+
+auto hash(const unsigned char, const unsigned char, const unsigned char) -> uint32_t;
+
+/* the hashes of the trigrams in a pattern, none when shorter than 3 bytes */
+auto of(const std::string_view) -> std::vector<uint32_t>;
+
+struct Filter {
+  /* the trigrams of text, with the last two bytes before it */
+  auto add(const std::string_view carry, const std::string_view text) -> void;
+  auto has(const uint32_t hash) const -> bool { return 0 != (bits[hash / 64] & (uint64_t{1} << hash % 64)); }
+
+  std::array<uint64_t, BITS / 64> bits{};
+};
+
+struct Stats {
+  /* blocks with a filter and bytes taken by their filters */
+  std::size_t blocks = 0;
+  std::size_t bytes = 0;
+
+  friend std::ostream & operator << (std::ostream &, const Stats &);
+};
+
+} // end of namespace trigram
@@ -0,0 +1,218 @@
+// Copyright Daniel Morilha 2025
+
+#include <cassert>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "cpu.h"
+#include "utf8.h"
+
+static_assert(4 == sizeof(wchar_t), "wide characters are expected to hold utf-32");
+
+namespace utf8 {
+
+namespace {
+
+using Widen = std::size_t (*)(const unsigned char * const, const std::size_t, wchar_t * const);
+using Scan = std::size_t (*)(const unsigned char * const, const std::size_t);
+
+/* scalar fallback */
+
+std::size_t widen_scalar(const unsigned char * const input, const std::size_t size, wchar_t * const output) {
+  std::size_t i = 0;
+  for (; size > i && 0x80 > input[i]; ++i) {
+    output[i] = input[i];
+  }
+  return i;
+}
+
+std::size_t printable_scalar(const unsigned char * const input, const std::size_t size) {
+  std::size_t i = 0;
+  for (; size > i && 0x20 <= input[i] && 0x7f != input[i]; ++i) { }
+  return i;
+}
+
+#if defined(__SSE2__)
+std::size_t widen_sse2(const unsigned char * const input, const std::size_t size, wchar_t * const output) {
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; size >= i + 16; i += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+    if (0 != _mm_movemask_epi8(bytes)) {
+      break;
+    }
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128i * const destination = reinterpret_cast<__m128i *>(output + i);
+    _mm_storeu_si128(destination + 0, _mm_unpacklo_epi16(low, zero));
+    _mm_storeu_si128(destination + 1, _mm_unpackhi_epi16(low, zero));
+    _mm_storeu_si128(destination + 2, _mm_unpacklo_epi16(high, zero));
+    _mm_storeu_si128(destination + 3, _mm_unpackhi_epi16(high, zero));
+  }
+  return i + widen_scalar(input + i, size - i, output + i);
+}
+
+std::size_t printable_sse2(const unsigned char * const input, const std::size_t size) {
+  const __m128i unit_separator = _mm_set1_epi8(0x1f);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  std::size_t i = 0;
+  for (; size >= i + 16; i += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+    // max(byte, 0x1f) == 0x1f only for c0 controls.
+    const __m128i control = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_max_epu8(bytes, unit_separator), unit_separator),
+        _mm_cmpeq_epi8(bytes, del));
+    const int mask = _mm_movemask_epi8(control);
+    if (0 != mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + printable_scalar(input + i, size - i);
+}
+
+__attribute__((target("avx2")))
+std::size_t widen_avx2(const unsigned char * const input, const std::size_t size, wchar_t * const output) {
+  std::size_t i = 0;
+  for (; size >= i + 32; i += 32) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+    if (0 != _mm256_movemask_epi8(bytes)) {
+      break;
+    }
+    for (std::size_t j = 0; 32 > j; j += 8) {
+      const __m128i eight = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(input + i + j));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i + j), _mm256_cvtepu8_epi32(eight));
+    }
+  }
+  return i + widen_sse2(input + i, size - i, output + i);
+}
+
+__attribute__((target("avx2")))
+std::size_t printable_avx2(const unsigned char * const input, const std::size_t size) {
+  const __m256i unit_separator = _mm256_set1_epi8(0x1f);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  std::size_t i = 0;
+  for (; size >= i + 32; i += 32) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+    const __m256i control = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, unit_separator), unit_separator),
+        _mm256_cmpeq_epi8(bytes, del));
+    const uint32_t mask = _mm256_movemask_epi8(control);
+    if (0 != mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + printable_sse2(input + i, size - i);
+}
+#endif // __SSE2__
+
+const struct Implementation {
+  Widen widen = widen_scalar;
+  Scan printable = printable_scalar;
+
+  Implementation() {
+#if defined(__SSE2__)
+    const bool avx2 = cpu::Level::AVX2 == cpu::level();
+    widen = avx2 ? widen_avx2 : widen_sse2;
+    printable = avx2 ? printable_avx2 : printable_sse2;
+#endif
+  }
+} implementation;
+
+constexpr bool is_valid(const uint32_t character, const uint32_t minimum) {
+  return minimum <= character
+    && (0xd800 > character || 0xdfff < character) /* surrogates */
+    && 0x10ffff >= character;
+}
+
+} // end of annonymous namespace
+
+std::size_t printable(const char * const input, const std::size_t size) {
+  return implementation.printable(reinterpret_cast<const unsigned char *>(input), size);
+}
+
+std::size_t Decoder::decode(const char * const input, const std::size_t size, wchar_t * const output) {
+  const unsigned char * iterator = reinterpret_cast<const unsigned char *>(input);
+  const unsigned char * const END = iterator + size;
+  wchar_t * character = output;
+
+  while (END > iterator) {
+    if (0 == remaining_) {
+      const std::size_t length = implementation.widen(iterator, END - iterator, character);
+      iterator += length;
+      character += length;
+      if (END == iterator) {
+        break;
+      }
+
+      const unsigned char c = *iterator++;
+      assert(0x80 <= c);
+      if (0xc2 > c) /* continuation byte or overlong two bytes sequence */ {
+        *character++ = REPLACEMENT;
+      } else if (0xe0 > c) {
+        character_ = c & 0x1f;
+        minimum_ = 0x80;
+        remaining_ = 1;
+      } else if (0xf0 > c) {
+        character_ = c & 0x0f;
+        minimum_ = 0x800;
+        remaining_ = 2;
+      } else if (0xf5 > c) {
+        character_ = c & 0x07;
+        minimum_ = 0x10000;
+        remaining_ = 3;
+      } else {
+        *character++ = REPLACEMENT;
+      }
+    } else {
+      const unsigned char c = *iterator;
+      if (0x80 != (c & 0xc0)) {
+        // truncated sequence, the current byte starts over.
+        *character++ = REPLACEMENT;
+        remaining_ = 0;
+        continue;
+      }
+      ++iterator;
+      character_ = (character_ << 6) | (c & 0x3f);
+      if (0 == --remaining_) {
+        *character++ = is_valid(character_, minimum_) ? character_ : REPLACEMENT;
+      }
+    }
+  }
+
+  return character - output;
+}
+
+std::size_t encode(const wchar_t character, char * const output) {
+  const uint32_t c = character;
+  if (0x80 > c) {
+    output[0] = c;
+    return 1;
+  } else if (0x800 > c) {
+    output[0] = 0xc0 | (c >> 6);
+    output[1] = 0x80 | (c & 0x3f);
+    return 2;
+  } else if (0x10000 > c) {
+    output[0] = 0xe0 | (c >> 12);
+    output[1] = 0x80 | ((c >> 6) & 0x3f);
+    output[2] = 0x80 | (c & 0x3f);
+    return 3;
+  }
+  output[0] = 0xf0 | (c >> 18);
+  output[1] = 0x80 | ((c >> 12) & 0x3f);
+  output[2] = 0x80 | ((c >> 6) & 0x3f);
+  output[3] = 0x80 | (c & 0x3f);
+  return 4;
+}
+
+std::size_t Decoder::flush(wchar_t * const output) {
+  if (0 == remaining_) {
+    return 0;
+  }
+  remaining_ = 0;
+  *output = REPLACEMENT;
+  return 1;
+}
+
+} // end of namespace utf8
@@ -0,0 +1,49 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Bulk utf-8 decoding in front of the parser.
+ *
+ * `printable` finds runs of bytes which do not contain c0 controls or delete,
+ * the only bytes which may change the parser state while in ground, and
+ * `Decoder` converts those runs to wide characters, 16 or 32 ascii bytes at a
+ * time when sse2 or avx2 are available. Invalid sequences are replaced by
+ * U+FFFD instead of interrupting the stream.
+ */
+namespace utf8 {
+
+constexpr wchar_t REPLACEMENT = 0xfffd;
+
+// number of leading bytes which are neither c0 controls nor delete.
+auto printable(const char * const, const std::size_t) -> std::size_t;
+
+struct Decoder {
+  /*
+   * decodes size bytes into output, which must have room for size + 1
+   * characters, returning the number of characters written. incomplete
+   * sequences at the end of the input are kept until the next call.
+   */
+  auto decode(const char * const, const std::size_t, wchar_t * const) -> std::size_t;
+
+  /*
+   * terminates an incomplete sequence, writing a replacement character into
+   * output when there was one, returns the number of characters written.
+   */
+  auto flush(wchar_t * const) -> std::size_t;
+
+  auto pending() const -> bool { return 0 < remaining_; }
+
+private:
+  uint32_t character_ = 0;
+  uint32_t minimum_ = 0;
+  uint8_t remaining_ = 0;
+};
+
+// writes up to 4 bytes into output, returning how many.
+auto encode(const wchar_t, char * const) -> std::size_t;
+
+} // end of namespace utf8
@@ -2,10 +2,10 @@
 
 #include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <vector>
 
 #include <cassert>
+#include <cstring>
 
 #include <errno.h>
 
@@ -16,6 +16,26 @@
 
 vt100::vt100(Screen & screen) : Terminal(screen) { }
 
+int vt100::pollfd() const {
+  return worker_ ? worker_->fd() : fd_.child;
+}
+
+ReadBuffer::Stats vt100::reads() const {
+  return worker_ ? worker_->reads() : buffer_.stats();
+}
+
+void vt100::thread() {
+  worker_ = std::make_unique<Worker>(fd_.child, buffer_.maximum(), recorder_.get());
+  drained();
+}
+
+void vt100::drained() {
+  if (worker_ && 0 < backlog_) {
+    /* the worker stops reading by itself, the same way this thread would */
+    worker_->allow(drained_ + backlog_);
+  }
+}
+
 void vt100::handleDecMode(const unsigned int code, const bool mode) {
 #if 0
   std::cerr << __func__ << "(" << code << ", " << (mode ? "true" : "false") << ");" << std::endl;
@@ -264,7 +284,7 @@ void vt100::handleDecMode(const unsigned int code, const bool mode) {
 
   case 2026:
     /* application synchronized updates equivalent to BSU/ESU */
-    assert(!"UNIMPLEMENTED");
+    screen_.synchronize(mode);
     break;
 
   case 8452:
@@ -278,8 +298,6 @@ void vt100::handleDecMode(const unsigned int code, const bool mode) {
   }
 }
 
-void vt100::handleAPC(const char) { }
-
 void vt100::handleSGRCommand(const int command) {
   switch (command) {
   case 0:
@@ -379,7 +397,7 @@ void vt100::handleSGRCommand(const int command) {
 
   case 30 ... 37:
     /* set foreground color */
-    rune_factory_.foreground_color = handleSGRColor({ 38, 5, command - 30, });
+    rune_factory_.foreground_color = palette(command - 30);
     break;
 
   case 38:
@@ -394,7 +412,7 @@ void vt100::handleSGRCommand(const int command) {
 
   case 40 ... 47:
     /* set background color */
-    rune_factory_.background_color = handleSGRColor({ 48,  5, command - 40, });
+    rune_factory_.background_color = palette(command - 40);
     break;
 
   case 48:
@@ -444,12 +462,12 @@ void vt100::handleSGRCommand(const int command) {
 
   case 90 ... 97:
     /* set foreground color from palette */
-    rune_factory_.foreground_color = handleSGRColor({ 38, 5, command - 82, });
+    rune_factory_.foreground_color = palette(command - 82);
     break;
 
   case 100 ... 107:
     /* set background color from palette */
-    rune_factory_.background_color = handleSGRColor({ 48, 5, command - 92, });
+    rune_factory_.background_color = palette(command - 92);
     break;
 
   default:
@@ -460,827 +478,749 @@ void vt100::handleSGRCommand(const int command) {
 }
 
 void vt100::handleSGR() {
+  const parser::Parameters & parameters = sequence_.parameters;
 #if DEBUG_ESCAPE_SEQUENCE
-  std::cerr << "Full SGR escape sequence " << escapeSequence_.data() << " " << std::endl;
+  std::cerr << "Full SGR escape sequence " << parameters << std::endl;
 #endif
 
-  std::vector<int> codes;
-
-  if (1 < escapeSequence_.size()) {
-    const EscapeSequence::iterator END = escapeSequence_.end();
-    EscapeSequence::iterator token = escapeSequence_.begin(),
-      iterator = token;
-    assert(token != END);
-    for (; END != token; ++iterator) {
-      if (':' == *iterator || ';' == *iterator || '\0' == *iterator) {
-        *iterator = '\0';
-        assert(END != token);
-        codes.push_back(atoi(token.base()));
-        token = ++iterator;
-      } else {
-        if ('0' > *iterator || '9' < *iterator) {
-          std::cerr << "*iterator " << *iterator << " " << std::endl;
-        }
-        assert('0' <= *iterator && '9' >= *iterator);
-      }
-    }
-    assert(!codes.empty());
-  } else {
+  if (parameters.empty()) {
     handleSGRCommand(0);
     return;
   }
 
-  /* requires a color parser */
-  if (38 == codes[0] || 48 == codes[0] || 58 == codes[0]) {
-    const Color color = handleSGRColor(codes);
-    return;
-  }
+  for (std::size_t i = 0; parameters.size() > i; ++i) {
+    const uint32_t command = parameters[i];
+    switch (command) {
+    case 38:
+      /* foreground color */
+      rune_factory_.foreground_color = handleSGRColor(parameters, i);
+      break;
+
+    case 48:
+      /* background color */
+      rune_factory_.background_color = handleSGRColor(parameters, i);
+      break;
+
+    case 58:
+      /* underline color, not supported, only consumed */
+      handleSGRColor(parameters, i);
+      break;
 
-  for (const int command : codes) {
-    handleSGRCommand(command);
+    default:
+      handleSGRCommand(command);
+      /* sub parameters such as 4:3 (curly underline) are not supported */
+      while (parameters.is_subparameter(i + 1)) {
+        ++i;
+      }
+      break;
+    }
   }
+  rune_factory_.update();
 }
 
 void vt100::handleCSI(const char c) {
-  escapeSequence_.push_back(c);
-  assert(/* arbitrary size */ 1024 > escapeSequence_.size());
-  const bool terminated = std::isalpha(c)
-    || '@' == c
-    || '{' == c
-    || '}' == c
-    || '~' == c
-    || '|' == c;
-
-  if (terminated) {
-    escapeSequence_.push_back('\0');
-    assert(1 < escapeSequence_.size());
+  const parser::Parameters & parameters = sequence_.parameters;
 #if DEBUG_ESCAPE_SEQUENCE
-    std::cerr << "Full CSI escape sequence " << escapeSequence_.data() << std::endl;
+  std::cerr << "Full CSI escape sequence " << sequence_ << c << std::endl;
 #endif
-    const char firstCharacter = escapeSequence_[0],
-      lastCharacter = escapeSequence_[escapeSequence_.size() - 2],
-      secondLastCharacter = escapeSequence_.size() < 3 ? '\0' :
-        escapeSequence_[escapeSequence_.size() - 3];
-
-      const bool isMultipleArguments = escapeSequence_.cend() == std::find_if(
-        escapeSequence_.cbegin(),
-        escapeSequence_.cend(),
-        [](const char c){ return ';' == c || ':' == c; });
-
-    switch (firstCharacter) {
-    case '!':
-      break;
-    case '?':
-      switch (secondLastCharacter) {
-      case '$':
-        switch (lastCharacter) {
-        case 'p':
-          assert(!"UNIMPLEMENTED");
-          break;
-        default:
-          assert(!"INVALID ESCAPE SEQUENCE");
-          break;
-        }
+
+  switch (sequence_.marker) {
+  case '?':
+    if ('$' == sequence_.intermediate()) {
+      switch (c) {
+      case 'p':
+        /* DECRQM - request dec private mode */
+        reportDecMode(parameters[0]);
         break;
       default:
-        switch (lastCharacter) {
-        case 'h': /* dec private mode set */
-        case 'l': /* dec private mode reset */
-          {
-            const bool mode = 'h' == lastCharacter;
-            const EscapeSequence::const_iterator END = escapeSequence_.cend();
-            EscapeSequence::const_iterator token = escapeSequence_.cbegin() + 1,
-              iterator = token;
-
-
-            assert(token != END);
-            for (; END != token; ++iterator) {
-              if (':' == *iterator || ';' == *iterator || lastCharacter == *iterator) {
-                assert(END != token);
-                const unsigned int code = std::atoi(token.base());
-                handleDecMode(code, mode);
-                token = iterator++;
-              } if ('\0' == *iterator) {
-                assert(1 == iterator - token && lastCharacter == *token);
-                break;
-              } else {
-                if ('0' > *iterator || '9' < *iterator) {
-                  std::cerr << "*iterator " << *iterator << " " << lastCharacter << std::endl;
-                }
-                assert('0' <= *iterator && '9' >= *iterator);
-              }
-            }
-          }
-          break;
-        case 'i':
-          /* media copy */
-          assert(!"UNIMPLEMENTED");
-          break;
-        case 'S':
-          /* set or request graphics attribute */
-          assert(!"UNIMPLEMENTED");
-          break;
-        case 'n':
-          /* device status report */
-          assert(!"UNIMPLEMENTED");
-          break;
-        default:
-          assert(!"INVALID ESCAPE SEQUENCE");
-          break;
+        assert(!"INVALID ESCAPE SEQUENCE");
+        break;
+      }
+      break;
+    }
+    switch (c) {
+    case 'h': /* dec private mode set */
+    case 'l': /* dec private mode reset */
+      {
+        const bool mode = 'h' == c;
+        for (std::size_t i = 0; parameters.size() > i; ++i) {
+          handleDecMode(parameters[i], mode);
         }
       }
       break;
-    case '>':
+    case 'i':
+      /* media copy */
+      assert(!"UNIMPLEMENTED");
       break;
-    case '=':
-      switch (lastCharacter) {
-      case 'c':
-        assert(!"UNIMPLEMENTED");
-        break;
-      default:
-        assert(!"INVALID ESCAPE SEQUENCE");
-        break;
-      }
+    case 'S':
+      /* set or request graphics attribute */
+      assert(!"UNIMPLEMENTED");
+      break;
+    case 'n':
+      /* device status report */
+      assert(!"UNIMPLEMENTED");
       break;
     default:
-      switch (lastCharacter) {
-      case 'm':
-        /* SGR - change one of more text attributes */
-        assert('\0' == escapeSequence_.back());
-        escapeSequence_.pop_back();
-        assert('m' == escapeSequence_.back());
-        escapeSequence_.pop_back();
-        escapeSequence_.push_back('\0');
-        handleSGR();
-        break;
+      assert(!"INVALID ESCAPE SEQUENCE");
+      break;
+    }
+    return;
 
-      case '@':
-        /* The normal character attribute.
-         * The cursor remains at the beginning of the blank characters.
-         * Text between the cursor and right margin moves to the right.
-         */
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.insert(argument);
-        }
-        break;
+  case '>':
+    return;
 
-      case 'a':
-        /* HPR - move cursor right (forward) Ps lines */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case '=':
+    switch (c) {
+    case 'c':
+      assert(!"UNIMPLEMENTED");
+      break;
+    default:
+      assert(!"INVALID ESCAPE SEQUENCE");
+      break;
+    }
+    return;
 
-      case 'A':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor_up(0 < argument ? argument : 1);
-        }
-        break;
+  default:
+    break;
+  }
 
-      case 'B':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor_down(0 < argument ? argument : 1);
-        }
-        break;
+  switch (sequence_.intermediate()) {
+  case '\0':
+    break;
+  case '!':
+    /* DECSTR - soft terminal reset */
+    return;
+  case ' ':
+    /* DECSCUSR - set cursor style, SL, SR and others */
+    return;
+  default:
+    assert(!"UNIMPLEMENTED");
+    return;
+  }
 
-      case 'C':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor_forward(0 < argument ? argument : 1);
-        }
-        break;
+  switch (c) {
+  case 'm':
+    /* SGR - change one of more text attributes */
+    handleSGR();
+    break;
 
-      case 'D':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor_backward(0 < argument ? argument : 1);
-        }
-        break;
+  case '@':
+    /* The normal character attribute.
+     * The cursor remains at the beginning of the blank characters.
+     * Text between the cursor and right margin moves to the right.
+     */
+    screen_.insert(parameters.get(0, 1));
+    break;
 
-      case 'E':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor(1, screen_.line() + 0 < argument ? argument : 1);
-        }
-        break;
+  case 'a':
+    /* HPR - move cursor right (forward) Ps lines */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'F':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor(1, screen_.line() - 0 < argument ? argument : 1);
-        }
-        break;
+  case 'A':
+    screen_.move_cursor_up(parameters.get(0, 1));
+    break;
 
-      case 'G':
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.move_cursor(0 < argument ? argument : 1, screen_.line());
-        }
-        break;
+  case 'B':
+    screen_.move_cursor_down(parameters.get(0, 1));
+    break;
 
-      case 'H':
-        {
-          uint16_t column = 1, line = 1;
-          if (2 < escapeSequence_.size()) {
-            std::istringstream stream{
-              std::string{escapeSequence_.begin(), escapeSequence_.end()}};
-            stream >> line;
-            char delimiter;
-            stream >> delimiter;
-            assert(';' == delimiter);
-            stream >> column;
-            column = std::max<uint16_t>(1, column);
-            line = std::max<uint16_t>(1, line);
-            assert(screen_.lines() >= line);
-            assert(screen_.columns() >= column);
-          }
-          screen_.move_cursor(column, line);
-        } break;
-
-      case 'J':
-        {
-          const std::size_t size = escapeSequence_.size();
-          if (2 == size) {
-            screen_.erase_display();
-          } else if (3 == size)  {
-            const int32_t argument = std::atoi(escapeSequence_.data());
-            switch (argument) {
-            case 2:
-              screen_.erase_display();
-              break;
-            case 3:
-              screen_.erase_scrollback();
-              break;
-            default:
-              assert(!"UNIMPLEMENTED");
-              break;
-            }
-          }
-        } break;
-
-      case 'K':
-        screen_.erase_line_right();
-        break;
+  case 'C':
+    screen_.move_cursor_forward(parameters.get(0, 1));
+    break;
 
-      case 'L':
-        /* IL - insert line at cursor shift rest down */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'D':
+    screen_.move_cursor_backward(parameters.get(0, 1));
+    break;
 
-      case 'e':
-        /* VPR - move cursor down Ps lines */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'E':
+    /* CNL - move cursor to the beginning of Ps lines down */
+    screen_.move_cursor(1, std::min<int32_t>(screen_.lines(), screen_.line() + parameters.get(0, 1)));
+    break;
 
-      case '`':
-        /* CBT - move cursor to column Ps */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'F':
+    /* CPL - move cursor to the beginning of Ps lines up */
+    screen_.move_cursor(1, std::max<int32_t>(1, screen_.line() - parameters.get(0, 1)));
+    break;
 
-      case 'd':
-        /* VPA - move cursor to row Ps */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'G':
+    screen_.move_cursor(parameters.get(0, 1), screen_.line());
+    break;
 
-      case 'r': {
-          /* DECSTBM - set scroll region */
-          //TODO: make a function
-          int64_t top = 1, bottom = 1;
-          if ('r' != escapeSequence_.front()) {
-            std::istringstream stream{
-              std::string{escapeSequence_.begin(), escapeSequence_.end()}};
-            stream >> top;
-            char delimiter;
-            stream >> delimiter;
-            assert(';' == delimiter);
-            stream >> bottom;
-            top = std::min<int64_t>(1, top);
-            bottom = 1 > bottom ? screen_.lines() - 1 : bottom;
-            --top;
-            --bottom;
-          } else {
-            assert(!"UNIMPLEMENTED");
-          }
-
-          if (bottom > top) {
-            screen_.move_cursor(1, 1);
-            /* sets scroll region top and bottom */
-          } else {
-            assert(!"INVALID DECSTBM SEQUENCE");
-          }
-        } break;
-
-      case 'I':
-        /* CHT - cursor forward Ps tabulations */
-        assert(!"UNIMPLEMENTED");
+  case 'H':
+    {
+      const uint16_t line = parameters.get(0, 1),
+        column = parameters.get(1, 1);
+      assert(screen_.lines() >= line);
+      assert(screen_.columns() >= column);
+      screen_.move_cursor(column, line);
+    } break;
+
+  case 'J':
+    if (parameters.empty()) {
+      screen_.erase_display();
+    } else {
+      switch (parameters[0]) {
+      case 2:
+        screen_.erase_display();
         break;
-
-      case 'Z':
-        /* CBT - cursor back Ps tabulations */
-        assert(!"UNIMPLEMENTED");
+      case 3:
+        screen_.erase_scrollback();
         break;
-
-      case 'h':
-        /* SM - set mode */
+      default:
         assert(!"UNIMPLEMENTED");
         break;
+      }
+    } break;
 
-      case 'l':
-        /* RM - reset mode */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'K':
+    screen_.erase_line_right();
+    break;
 
-      case 'g':
-        /* TBC - tabulation clear */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'L':
+    /* IL - insert line at cursor shift rest down */
+    screen_.insert_lines(parameters.get(0, 1));
+    break;
 
-      case 'f':
-        /* HVP - move cursor to Px, Py */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'e':
+    /* VPR - move cursor down Ps lines */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'c':
-        /* report vt340 type device with sixel */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case '`':
+    /* CBT - move cursor to column Ps */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'n':
-        /* DSR - device status report */
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          reportDeviceStatus(argument);
-        } break;
+  case 'd':
+    /* VPA - move cursor to row Ps */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'M':
-        /* DL - delete lines */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'r': {
+      /* DECSTBM - set scroll region, no parameters resets it */
+      const int64_t top = parameters.get(0, 1),
+            bottom = std::min<int64_t>(parameters.get(1, screen_.lines()), screen_.lines());
+      if (bottom > top) {
+        screen_.margins(top, bottom);
+      }
+    } break;
 
-      case 'T':
-        /* SD - scroll down */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'I':
+    /* CHT - cursor forward Ps tabulations */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'X':
-        /* ECH - erase Ps characters */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'Z':
+    /* CBT - cursor back Ps tabulations */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'P':
-        /* DCH - erase Ps characters */
-        {
-          const int argument = std::atoi(escapeSequence_.data());
-          screen_.erase(argument);
-        }
-        break;
+  case 'h':
+    /* SM - set mode */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'i':
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'l':
+    /* RM - reset mode */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'u':
-        /* SCORC - restore cursor */
-        /* DECSMBV - set margin-bell volume */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'g':
+    /* TBC - tabulation clear */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 's':
-        /* DECSLRM - set left and right margin */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'f':
+    /* HVP - move cursor to Px, Py */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 'q':
-        /* DECLL - manipulate keyboard leds */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'c':
+    /* report vt340 type device with sixel */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-      case 't':
-        /* XTWINOPS - xterm window ops */
-        assert(!"UNIMPLEMENTED");
-        break;
+  case 'n':
+    /* DSR - device status report */
+    reportDeviceStatus(parameters[0]);
+    break;
 
-      default:
-        assert(!"INVALID ESCAPE SEQUENCE");
-        break;
-      }
-      break;
-    }
-    escapeSequence_.clear();
-    state_ = LITERAL;
-  }
-}
+  case 'M':
+    /* DL - delete lines */
+    screen_.delete_lines(parameters.get(0, 1));
+    break;
 
-void vt100::handleOSC(const char c) {
-  assert(/* arbitrary size */ 1024 > escapeSequence_.size());
-  const bool terminated = '\a' == c
-    || (1 <= escapeSequence_.size()
-    && '\e' == escapeSequence_.back()
-    && '\\' == c);
-
-  escapeSequence_.push_back(c);
-
-  if (terminated) {
-    if ('\a' == escapeSequence_.back()) {
-      escapeSequence_.pop_back();
-    } else if ('\\' == escapeSequence_.back()) {
-      escapeSequence_.pop_back();
-      if ('\e' == escapeSequence_.back()) {
-        escapeSequence_.pop_back();
-      } else {
-        assert(!"UNREACHEABLE");
-      }
-    } else {
-      assert(!"UNREACHEABLE");
-    }
+  case 'S':
+    /* SU - scroll up */
+    screen_.scroll(parameters.get(0, 1));
+    break;
 
-    escapeSequence_.push_back('\0');
+  case 'T':
+    /* SD - scroll down */
+    screen_.scroll(-static_cast<int>(parameters.get(0, 1)));
+    break;
 
-    assert(1 < escapeSequence_.size());
+  case 'X':
+    /* ECH - erase Ps characters */
+    screen_.erase_characters(parameters.get(0, 1));
+    break;
 
-    const unsigned int code = std::atoi(escapeSequence_.data());
-    switch (code) {
-    case 0:
-      /* change window title */
-      {
-        const std::string title = escapeSequence_.data() + 2;
-        screen_.setTitle(title);
-      } break;
+  case 'P':
+    /* DCH - erase Ps characters */
+    screen_.erase(parameters.get(0, 1));
+    break;
 
-    default:
-      assert(!"UNIMPLEMENTED");
-      break;
-    }
+  case 'i':
+    assert(!"UNIMPLEMENTED");
+    break;
 
-    escapeSequence_.clear();
-    state_ = LITERAL;
-  }
-}
+  case 'u':
+    /* SCORC - restore cursor */
+    /* DECSMBV - set margin-bell volume */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-void vt100::handleDCS(const char) { }
+  case 's':
+    /* DECSLRM - set left and right margin */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-void vt100::handlePM(const char) { }
+  case 'q':
+    /* DECLL - manipulate keyboard leds */
+    assert(!"UNIMPLEMENTED");
+    break;
 
-vt100::CharacterType vt100::handleCharacter(const wchar_t c) {
-  switch(state_) {
-  case LITERAL:
-    switch (c) {
-    case '\e':
-      state_ = ESCAPE;
-      break;
-    case '\n':
-      screen_.pushBack(rune_factory_.make(c));
-      return CharacterType::terminal;
-    default:
-      screen_.pushBack(rune_factory_.make(c));
-      break;
-    }
+  case 't':
+    /* XTWINOPS - xterm window ops */
+    assert(!"UNIMPLEMENTED");
     break;
 
-  case CSI:
-    switch (c) {
-    case '\a':
-      /* bell */
-      break;
-    case '\b':
-      /* backspace */
-      break;
-    case '\r':
-      /* carriage return */
-      break;
-    case '\f':
-    case '\v':
-    case '\n':
-      /* carriage return */
-      /* line feed */
-      break;
-    default:
-      handleCSI(c);
-      break;
-    }
+  default:
+    assert(!"INVALID ESCAPE SEQUENCE");
+    break;
+  }
+}
+
+void vt100::handleOSC() {
+  switch (string_.code()) {
+  case 0:
+    /* change window title */
+    screen_.setTitle(std::string{string_.text()});
     break;
 
-  case ESCAPE:
+  default:
+    assert(!"UNIMPLEMENTED");
+    break;
+  }
+}
+
+void vt100::handleDCS(const char) { }
+
+void vt100::handleESC(const char c) {
 #if DEBUG_ESCAPE_SEQUENCE
-    std::cerr << "Escape sequence " << static_cast<char>(c) << std::endl;
+  std::cerr << "Escape sequence " << sequence_ << c << std::endl;
 #endif
-    switch (c) {
-    case '[':
-      state_ = CSI;
-      break;
-    case ']':
-      state_ = OSC;
-      break;
-    case 'P':
-      state_ = DCS;
-      break;
-    case '_':
-      state_ = APC;
+  if ('\0' != sequence_.intermediate()) {
+    switch (sequence_.intermediate()) {
+    case '(':
+      /* designate g0 character set */
       break;
-    case 'M':
-      /* reverse line feed */
-      screen_.reverse_line_feed();
-      state_ = LITERAL;
+    case ')':
+      /* designate g1 character set */
+      assert(!"UNIMPLEMENTED");
       break;
-    case 'E':
-      /* new line */
+    case '*':
+      /* designate g2 character set */
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'D':
-      /* line feed */
+    case '+':
+      /* designate g3 character set */
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
     case '#':
+      /* dec screen alignment test and line attributes */
       assert(!"UNIMPLEMENTED");
-      state_ = DEC;
       break;
-    case 'H':
-      /* set tab stop at current column */
+    case '%':
+    case ' ':
+      /* other escape control sequences */
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case '(':
-      state_ = CHARSET_G0;
+    default:
+      assert(!"INVALID ESCAPE SEQUENCE");
       break;
-    case ')':
-      state_ = CHARSET_G1;
+    }
+    return;
+  }
+
+  switch (c) {
+  case 'M':
+    /* reverse line feed */
+    screen_.reverse_line_feed();
+    break;
+  case 'E':
+    /* new line */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'D':
+    /* line feed */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'H':
+    /* set tab stop at current column */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'g':
+    /* bell */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '=':
+    /* application keypad */
+    std::cout << "set application keypad mode (currently has no actual effect)" << std::endl;
+    break;
+  case '>':
+    /* normal keypad */
+    std::cout << "set normal keypad mode (currently has no actual effect)" << std::endl;
+    break;
+  case '`':
+    /* disable manual input */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'b':
+    /* enable manual input */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'c':
+    /* reset initial state */
+    std::cerr << "reset initial state" << std::endl;
+    rune_factory_.reset();
+    break;
+  case '7':
+    /* save cursor */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '8':
+    /* restore cursor */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '6':
+    /* DECBI */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '9':
+    /* DECFI */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'd':
+    /* coding method delimiter */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'n':
+    /* invoke the g2 charset into gl */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'o':
+    /* invoke the g2 charset into gl */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '|':
+    /* invoke the g3 charset into gl */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '}':
+    /* invoke the g2 charset into gl */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '~':
+    /* invoke the g1 charset into gl */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'N':
+    /* single shift select of g2 character set */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'O':
+    /* single shift select of g3 character set */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'k':
+    /* old tabtitle set sequence */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'V':
+    /* start of guarded area */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case 'W':
+    /* end of guarded area */
+    assert(!"UNIMPLEMENTED");
+    break;
+  case '\\':
+    /* st */
+    break;
+  default:
+    assert(!"INVALID ESCAPE SEQUENCE");
+    break;
+  }
+}
+
+void vt100::execute(const unsigned char c) {
+  switch (c) {
+  case '\a': // bell
+  case '\b': // backspace
+  case '\n': // new line
+  case '\r': // carriage return
+  case '\t': // horizontal tab
+    screen_.pushBack(rune_factory_.make(c));
+    break;
+  case '\f': // form feed
+  case '\v': // vertical tab
+    screen_.pushBack(rune_factory_.make(L'\n'));
+    break;
+  default:
+    /* nul, shift in / out and others have no effect */
+    break;
+  }
+}
+
+void vt100::print(const char * const input, const std::size_t size) {
+  const std::size_t capacity = characters_.size() - 1;
+  for (std::size_t offset = 0; size > offset; offset += capacity) {
+    const std::size_t length = decoder_.decode(input + offset,
+        std::min(capacity, size - offset), characters_.data());
+    assert(characters_.size() >= length);
+    runes_.clear();
+    for (std::size_t i = 0; length > i; ++i) {
+      runes_.emplace_back(rune_factory_.make(characters_[i]));
+    }
+    screen_.print(runes_);
+  }
+}
+
+/*
+ * drives the parser table, terminal characters finish a line or an escape
+ * sequence, which are the points where control may be returned.
+ */
+vt100::CharacterType vt100::handleCharacter(const unsigned char c) {
+  const parser::Transition & transition = parser::transition(state_, c);
+  bool terminal = false;
+  for (const parser::Action action : { transition.exit, transition.action, transition.entry, }) {
+    switch (action) {
+    case parser::Action::NONE:
+    case parser::Action::IGNORE:
       break;
-    case '*':
-      state_ = CHARSET_G2;
+
+    case parser::Action::PRINT:
+      print(reinterpret_cast<const char *>(&c), 1);
       break;
-    case '+':
-      state_ = CHARSET_G3;
+
+    case parser::Action::EXECUTE:
+      execute(c);
+      terminal |= '\n' == c;
       break;
-    case '%':
-      state_ = OTHER_ESC_CTL_SEQ;
+
+    case parser::Action::CLEAR:
+      sequence_.clear();
       break;
-    case ' ':
-      state_ = OTHER_ESC_CTL_SEQ;
+
+    case parser::Action::COLLECT:
+      sequence_.collect(c);
       break;
-    case 'g':
-      /* bell */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+
+    case parser::Action::PARAM:
+      sequence_.parameters.add(c);
       break;
-    case '=':
-      /* application keypad */
-      std::cout << "set application keypad mode (currently has no actual effect)" << std::endl;
-      state_ = LITERAL;
+
+    case parser::Action::OSC_START:
+      string_.clear();
       break;
-    case '>':
-      /* normal keypad */
-      std::cout << "set normal keypad mode (currently has no actual effect)" << std::endl;
-      state_ = LITERAL;
+
+    case parser::Action::OSC_PUT:
+      string_.put(c);
       break;
-    case '`':
-      /* disable manual input */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+
+    case parser::Action::CSI_DISPATCH:
+      handleCSI(c);
+      terminal = true;
       break;
-    case 'b':
-      /* enable manual input */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+
+    case parser::Action::ESC_DISPATCH:
+      handleESC(c);
+      terminal = true;
       break;
-    case 'c':
-      /* reset initial state */
-      std::cerr << "reset initial state" << std::endl;
-      rune_factory_.reset();
-      state_ = LITERAL;
+
+    case parser::Action::OSC_END:
+      handleOSC();
+      terminal = true;
       break;
-    case '7':
-      /* save cursor */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+
+    case parser::Action::HOOK:
+    case parser::Action::UNHOOK:
       break;
-    case '8':
-      /* restore cursor */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+
+    case parser::Action::PUT:
+      handleDCS(c);
       break;
-    case '6':
-      /* DECBI */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+
+    default:
+      assert(!"UNREACHABLE");
       break;
-    case '9':
-      /* DECFI */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+    }
+  }
+  state_ = transition.state;
+  return terminal ? CharacterType::terminal : CharacterType::nonterminal;
+}
+
+/*
+ * DECRPM, 1 means set, 2 reset and 0 not recognized. only the modes
+ * applications probe before relying on them are reported.
+ */
+void vt100::reportDecMode(const uint32_t mode) {
+  uint32_t value = 0;
+  switch (mode) {
+  case 2026:
+    value = screen_.synchronized() ? 1 : 2;
+    break;
+  default:
+    break;
+  }
+  escape("\e[?%u;%u$y", mode, value);
+}
+
+void vt100::reportDeviceStatus(const int argument) {
+  switch (argument) {
+  case 6: /* report cursor position */
+    escape("\e[?%u;%uR", screen_.line(), screen_.column());
+    break;
+  default:
+    assert(!"UNIMPLEMENTED");
+    break;
+  }
+}
+
+/*
+ * the 256 colors palette, 16 system colors followed by a 6x6x6 color cube
+ * and a grayscale ramp.
+ */
+Color vt100::palette(const uint32_t palette_index) {
+  const float alpha = 1.f;
+  const int16_t index = palette_index;
+#if 0 /* not sure if this is really needed */
+  index = std::min(index, 255);
+#endif
+  assert(0 <= index);
+  if (8  > index) /* background */ {
+    switch (index) {
+    case 0:
+      return colors::black;
       break;
-    case 'd':
-      /* coding method delimiter */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+    case 1:
+      return colors::red;
       break;
-    case 'n':
-      /* invoke the g2 charset into gl */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+    case 2:
+      return colors::green;
       break;
-    case 'o':
-      /* invoke the g2 charset into gl */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+    case 3:
+      return colors::yellow;
       break;
-    case '|':
-      /* invoke the g3 charset into gl */
-      assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
+    case 4:
+      return colors::blue;
+      break;
+    case 5:
+      return colors::magenta;
+      break;
+    case 6:
+      return colors::cyan;
+      break;
+    case 7:
+      return colors::white;
+      break;
+    default:
+      assert(!"UNRECHEABLE");
       break;
-    case '}':
-      /* invoke the g2 charset into gl */
+    }
+  } else if (16  > index) {
+    switch (index) {
+    case 8:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case '~':
-      /* invoke the g1 charset into gl */
+    case 9:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'N':
-      /* single shift select of g2 character set */
+    case 10:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'O':
-      /* single shift select of g3 character set */
+    case 11:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'k':
-      /* old tabtitle set sequence */
+    case 12:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'X':
-      /* start of string */
+    case 13:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'V':
-      /* start of guarded area */
+    case 14:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-    case 'W':
-      /* end of guarded area */
+    case 15:
       assert(!"UNIMPLEMENTED");
-      state_ = LITERAL;
       break;
-
-    case '\\':
-      /* st */
-      return CharacterType::nonterminal;
-
-    case '\e':
-      return CharacterType::nonterminal;
-
     default:
-      assert(!"INVALID ESCAPE SEQUENCE");
-      state_ = LITERAL;
+      assert(!"UNRECHEABLE");
       break;
     }
-    break;
-  case CHARSET_G0:
-    break;
-  case CHARSET_G1:
-    assert(!"UNIMPLEMENTED");
-    break;
-  case CHARSET_G2:
-    assert(!"UNIMPLEMENTED");
-    break;
-  case CHARSET_G3:
-    assert(!"UNIMPLEMENTED");
-    break;
-  case OTHER_ESC_CTL_SEQ:
-    assert(!"UNIMPLEMENTED");
-    state_ = LITERAL;
-    break;
-  case OSC:
-    handleOSC(c);
-    break;
-  case PM:
-    handlePM(c);
-    break;
-  case DCS:
-    handleDCS(c);
-    break;
-  case APC:
-    handleAPC(c);
-    break;
-  case DEC:
-    assert(!"UNIMPLEMENTED");
-    break;
-  case TITLE:
-    assert(!"UNIMPLEMENTED");
-    break;
-  default:
-    assert(!"UNREACHABLE");
-    break;
+  } else if (232 > index) /* "extended" */ {
+      int16_t i = index - 16;
+      const float blue = ((i % 6) * 255) / 5.0;
+      i /= 6;
+      const float green = ((i  % 6) * 255) / 5.0;
+      i /= 6;
+      const float red = ((i % 6) * 255) / 5.0;
+      return Color{.red = red / 255.f, .green = green / 255.f, .blue = blue / 255.f, .alpha = alpha};
+  } else if (256 > index) /* grayscale */ {
+      const float i = ((index - 232) * 10 + 8) / 255.f;
+      return Color{.red = i, .green = i, .blue = i, .alpha = alpha};
+  } else {
+    std::cerr << "color index " << index << std::endl;
+    assert(!"OUT OF BOUND COLOR");
   }
-  return CharacterType::terminal;
+  return colors::white;
 }
 
-void vt100::reportDeviceStatus(const int argument) {
-  switch (argument) {
-  case 6: /* report cursor position */
-    escape("\e[?%u;%uR", screen_.line(), screen_.column());
-    break;
-  default:
-    assert(!"UNIMPLEMENTED");
-    break;
-  }
-}
+/*
+ * extended colors, either in the "38;5;index" and "38;2;red;green;blue"
+ * forms or in their sub parameter equivalents "38:5:index" and
+ * "38:2:colorspace:red:green:blue". index points to the 38, 48 or 58
+ * parameter and is advanced to the last parameter consumed.
+ */
+Color vt100::handleSGRColor(const parser::Parameters & parameters, std::size_t & index) {
+  switch (parameters[index + 1]) {
+  case 5:
+    index += 2;
+    return palette(parameters[index]);
 
-Color vt100::handleSGRColor(const std::vector<int> & codes) {
-  if (5 == codes[1]) {
-    const float alpha = 1.f;
-    int16_t index = codes[2];
-#if 0 /* not sure if this is really needed */
-    index = std::min(index, 255);
-#endif
-    assert(0 <= index);
-    if (8  > index) /* background */ {
-      switch (index) {
-      case 0:
-        return colors::black;
-        break;
-      case 1:
-        return colors::red;
-        break;
-      case 2:
-        return colors::green;
-        break;
-      case 3:
-        return colors::yellow;
-        break;
-      case 4:
-        return colors::blue;
-        break;
-      case 5:
-        return colors::magenta;
-        break;
-      case 6:
-        return colors::cyan;
-        break;
-      case 7:
-        return colors::white;
-        break;
-      default:
-        assert(!"UNRECHEABLE");
-        break;
-      }
-    } else if (16  > index) {
-      switch (index) {
-      case 8:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 9:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 10:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 11:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 12:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 13:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 14:
-        assert(!"UNIMPLEMENTED");
-        break;
-      case 15:
-        assert(!"UNIMPLEMENTED");
-        break;
-      default:
-        assert(!"UNRECHEABLE");
-        break;
+  case 2:
+    {
+      index += 2;
+      if (parameters.is_subparameter(index + 3)) {
+        /* skips the color space identifier */
+        ++index;
       }
-    } else if (232 > index) /* "extended" */ {
-        int16_t i = index - 16;
-        const float blue = ((i % 6) * 255) / 5.0;
-        i /= 6;
-        const float green = ((i  % 6) * 255) / 5.0;
-        i /= 6;
-        const float red = ((i % 6) * 255) / 5.0;
-        return Color(red, blue, green, alpha);
-    } else if (256 < index) /* grayscale */ {
-        const float i = ((index - 232) * 10 + 8) / 256.0 * 255.0;
-        return Color(i, i, i, alpha);
-    } else {
-      std::cerr << "color index " << index << std::endl;
-      assert(!"OUT OF BOUND COLOR");
+      const Color color{
+        .red = parameters[index] / 255.f,
+        .green = parameters[index + 1] / 255.f,
+        .blue = parameters[index + 2] / 255.f,
+        .alpha = 1.f,
+      };
+      index += 2;
+      return color;
     }
-  } else {
+
+  default:
     assert(!"UNIMPLEMENTED");
+    ++index;
+    break;
   }
   return colors::white;
 }
@@ -1291,75 +1231,104 @@ void vt100::handleEscape(const char * const sequence, const int length) {
   }
 }
 
-struct ScreenAutoCommit {
-  ~ScreenAutoCommit() { screen_.commit(); }
-  ScreenAutoCommit(Screen & s) : screen_(s) { }
-  auto begin(const uint64_t size = 0) -> void { screen_.begin(size); }
-  Screen & screen_;
-};
+/*
+ * applies the events published by the worker thread, in the same order
+ * they were parsed.
+ */
+bool vt100::apply(const std::optional<TimePoint> & t) {
+  worker_->acknowledge();
+  Worker::Queue & queue = worker_->queue();
+  Slice slice(budget, t);
+
+  while (Worker::Event * const event = queue.front()) {
+    /* the slot belongs to the worker again once popped */
+    const Worker::Event::Type type = event->type;
+    const uint32_t bytes = event->bytes;
+    switch (type) {
+    case Worker::Event::PRINT:
+      runes_.clear();
+      for (std::size_t i = 0; event->size > i; ++i) {
+        runes_.emplace_back(rune_factory_.make(event->characters[i]));
+      }
+      screen_.print(runes_);
+      break;
+
+    case Worker::Event::EXECUTE:
+      execute(event->c);
+      break;
+
+    case Worker::Event::CSI:
+      sequence_ = event->sequence;
+      handleCSI(event->c);
+      break;
+
+    case Worker::Event::ESC:
+      sequence_ = event->sequence;
+      handleESC(event->c);
+      break;
+
+    case Worker::Event::OSC:
+      string_ = event->string;
+      handleOSC();
+      break;
+    }
+    queue.pop();
+
+    slice.bytes += bytes;
+    if (Worker::Event::PRINT != type && slice.expire()) {
+      return false;
+    }
+  }
+
+  if (worker_->hangup() && nullptr == queue.front()) {
+    pollhup();
+  }
+  return true;
+}
 
 bool vt100::pollin(const std::optional<TimePoint> & t) {
-  ScreenAutoCommit auto_commit(screen_);
+  if (worker_) {
+    return apply(t);
+  }
+
+  Slice slice(budget, t);
   while (true) {
-    while (bufferIndex_ < bufferSize_) {
-      wchar_t character = 0;
-      {
-        const ssize_t size = bufferSize_ - bufferIndex_;
-        if (2048 <= size) {
-          auto_commit.begin(size);
-        }
-        const ssize_t bytes = mbrtowc(&character, &buffer_[bufferIndex_], size, /* mbstate_t = */ nullptr);
-        assert(4 >= bytes);
-        if (bytes > size) {
-          std::cerr << __func__ << " " << bytes << " " << size << std::endl;
-        }
-        assert(bytes <= size);
-        switch (bytes) {
-        case -2: /* incomplete */
-          if (0 < bufferIndex_) {
-            strncpy(&buffer_[0], &buffer_[bufferIndex_], size);
-          } else {
-            /* this means there is an incomplete sequence right at the beginning of the buffer */
-            std::cerr << "also odd" << std::endl;
-          }
-          bufferStart_ = size;
-          assert(4 > bufferStart_);
-          bufferIndex_ += size;
-          assert(bufferIndex_ == bufferSize_);
+    while ( ! buffer_.empty()) {
+      const std::span<const char> input = buffer_.front();
+      if (parser::State::GROUND == state_) {
+        /* decodes runs of printable characters in bulk */
+        const std::size_t length = utf8::printable(input.data(), input.size());
+        if (0 < length) {
+          print(input.data(), length);
+          buffer_.consume(length);
+          slice.bytes += length;
           continue;
-          break;
-
-        case -1: /* invalid */
-          std::cerr << "problems with utf-8: invalid number of bytes" << std::endl;
-          assert(!"INVALID");
-          break;
+        }
+      }
 
-        case 0:
-          std::cerr << "odd" << std::endl;
-          assert(!"UNRECHEABLE");
-          assert(0 == character);
-          break;
+      if (decoder_.pending()) {
+        /* a control character interrupted a utf-8 sequence */
+        const std::size_t length = decoder_.flush(characters_.data());
+        assert(1 == length);
+        screen_.pushBack(rune_factory_.make(characters_[0]));
+      }
 
-        default:
-          assert(0 < character);
-          bufferIndex_ += bytes;
-          const CharacterType type = handleCharacter(character);
-          /* if character type is terminal, we may return control */
-          if (CharacterType::terminal == type) {
-            if (t.has_value() && t.value() <= std::chrono::steady_clock::now()) {
-              return false;
-            }
-          }
-          break;
-        }
+      buffer_.consume(1);
+      const CharacterType type = handleCharacter(input[0]);
+      ++slice.bytes;
+      /* if character type is terminal, we may return control */
+      if (CharacterType::terminal == type && slice.expire()) {
+        return false;
       }
     }
 
-    assert(bufferSize_ >= bufferIndex_);
-    
+    if (backlogged()) {
+      break;
+    }
+
     {
-      assert(4 > bufferStart_);
-      const ssize_t size = read(fd_.child, buffer_.data() + bufferStart_, buffer_.size() - bufferStart_);
+      /* incomplete utf-8 sequences are carried over by the decoder */
+      const ssize_t size = buffer_.read(fd_.child);
       if (0 > size) {
         if (EAGAIN == errno) {
           break; // nothing left to read.
@@ -1371,15 +1340,14 @@ bool vt100::pollin(const std::optional<TimePoint> & t) {
           assert(!"ERROR");
         }
       } else {
-        if (2048 <= size) {
-          auto_commit.begin(size);
-        }
-        bufferSize_ = bufferStart_ + size;
-        assert(buffer_.size() >= bufferSize_);
         if (0 == size) {
-          break; // complete read operation.
-        } else {
-          bufferStart_ = bufferIndex_ = 0;
+          /* end of file, only when replaying */
+          pollhup();
+          break;
+        }
+        if (recorder_) {
+          assert(buffer_.front().size() == static_cast<std::size_t>(size));
+          recorder_->write(buffer_.front().data(), size);
         }
       }
     }
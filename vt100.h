@@ -3,11 +3,16 @@
 #pragma once
 
 #include <array>
+#include <memory>
 
+#include "parser.h"
 #include "terminal.h"
+#include "worker.h"
 
 struct vt100 : public Terminal {
   vt100(Screen &);
+  int pollfd() const override;
+  ReadBuffer::Stats reads() const override;
 protected:
   void handleEscape(const char * const, const int);
 
@@ -17,59 +22,42 @@ private:
     terminal,
   };
 
-  using EscapeSequence = std::vector<char>;
   bool pollin(const std::optional<TimePoint> &) override;
+  void drained() override;
+  void thread() override;
 
-  CharacterType handleCharacter(const wchar_t);
+  bool apply(const std::optional<TimePoint> &);
+
+  CharacterType handleCharacter(const unsigned char);
 
   void alternative_buffer_on();
   void alternative_buffer_off();
 
-  void handleAPC(const char);
+  void execute(const unsigned char);
+  void print(const char * const, const std::size_t);
+
   void handleCSI(const char);
   void handleDCS(const char);
   void handleDecMode(const unsigned int, const bool);
-  void handleOSC(const char);
-  void handlePM(const char);
+  void handleESC(const char);
+  void handleOSC();
   void handleSGR();
-  Color handleSGRColor(const std::vector<int> &);
+  Color handleSGRColor(const parser::Parameters &, std::size_t &);
   void handleSGRCommand(const int);
 
+  void reportDecMode(const uint32_t);
   void reportDeviceStatus(const int32_t);
 
+  static Color palette(const uint32_t);
 
-  EscapeSequence escapeSequence_;
+  parser::Sequence sequence_;
+  parser::String string_;
 
   rune::RuneFactory rune_factory_;
 
-  enum {
-    LITERAL,
-
-    ESCAPE,
-
-    APC,
-    CSI,
-    DCS,
-    DEC,
-    OSC,
-    PM,
-
-    DEC_SPECIAL,
+  std::vector<rune::Rune> runes_;
 
-    CHARSET_G0,
-    CHARSET_G1,
-    CHARSET_G2,
-    CHARSET_G3,
+  parser::State state_ = parser::State::GROUND;
 
-    OTHER_ESC_CTL_SEQ,
-
-    TITLE,
-
-    UPPER_BOUND,
-  } state_ = LITERAL;
-
-  uint16_t bufferIndex_ = 0;
-  uint16_t bufferSize_ = 0;
-  uint8_t bufferStart_ = 0;
+  std::unique_ptr<Worker> worker_;
 };
-
@@ -0,0 +1,273 @@
+// Copyright Daniel Morilha 2025
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <cassert>
+#include <cstring>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "worker.h"
+
+using namespace std::chrono_literals;
+
+Worker::Worker(const int child, const std::size_t maximum, recording::Writer * const recorder) :
+  buffer_(maximum), child_(child), recorder_(recorder) {
+  eventfd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  assert(0 <= eventfd_);
+  thread_ = std::thread(&Worker::run, this);
+}
+
+Worker::~Worker() {
+  running_.store(false, std::memory_order_release);
+  allow(UINT64_MAX);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (0 <= eventfd_) {
+    close(eventfd_);
+  }
+}
+
+void Worker::allow(const uint64_t limit) {
+  if (limit != limit_.exchange(limit, std::memory_order_release)) {
+    limit_.notify_one();
+  }
+}
+
+void Worker::acknowledge() {
+  uint64_t value = 0;
+  const ssize_t result = read(eventfd_, &value, sizeof(value));
+  assert(sizeof(value) == result || (0 > result && EAGAIN == errno));
+}
+
+/*
+ * waits for a free slot when the main thread falls behind, which in turn
+ * stops reading the pty and lets the kernel throttle the child.
+ */
+Worker::Event & Worker::claim() {
+  for (uint32_t attempt = 0; ; ++attempt) {
+    Event * const event = queue_.back();
+    if (nullptr != event) {
+      return *event;
+    }
+    if ( ! running_.load(std::memory_order_relaxed)) {
+      /* stopping, nobody consumes the queue anymore */
+      return discard_;
+    }
+    if (0 == attempt) {
+      const uint64_t value = 1;
+      const ssize_t result = write(eventfd_, &value, sizeof(value));
+      assert(sizeof(value) == result);
+    }
+    if (64 > attempt) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(100us);
+    }
+  }
+}
+
+void Worker::emit(const Event::Type type, const char c) {
+  if (nullptr != open_) {
+    queue_.push();
+    open_ = nullptr;
+  }
+  Event & event = claim();
+  event.type = type;
+  event.c = c;
+  event.bytes = consumed_;
+  consumed_ = 0;
+  switch (type) {
+  case Event::CSI:
+  case Event::ESC:
+    event.sequence = sequence_;
+    break;
+  case Event::OSC:
+    event.string = string_;
+    break;
+  default:
+    break;
+  }
+  queue_.push();
+}
+
+/* the print event being filled, publishing it first when it is full */
+Worker::Event & Worker::open() {
+  if (nullptr != open_ && Event::CAPACITY <= open_->size) {
+    queue_.push();
+    open_ = nullptr;
+  }
+  if (nullptr == open_) {
+    open_ = &claim();
+    open_->type = Event::PRINT;
+    open_->size = 0;
+    open_->bytes = 0;
+  }
+  return *open_;
+}
+
+void Worker::print(const char * const input, const std::size_t size) {
+  for (std::size_t offset = 0; size > offset; ) {
+    Event & event = open();
+    /* decoding may write one character more than it consumes */
+    const std::size_t length = std::min<std::size_t>(Event::CAPACITY - event.size, size - offset);
+    event.size += decoder_.decode(input + offset, length, event.characters.data() + event.size);
+    event.bytes += length;
+    offset += length;
+  }
+}
+
+void Worker::publish() {
+  if (nullptr != open_) {
+    queue_.push();
+    open_ = nullptr;
+  }
+  const uint64_t value = 1;
+  const ssize_t result = write(eventfd_, &value, sizeof(value));
+  assert(sizeof(value) == result);
+}
+
+/* mirrors vt100::handleCharacter, dispatches become events */
+void Worker::handleCharacter(const unsigned char c) {
+  const parser::Transition & transition = parser::transition(state_, c);
+  if (parser::Action::PRINT != transition.action) {
+    /* printing counts its own bytes */
+    ++consumed_;
+  }
+  for (const parser::Action action : { transition.exit, transition.action, transition.entry, }) {
+    switch (action) {
+    case parser::Action::NONE:
+    case parser::Action::IGNORE:
+    case parser::Action::HOOK:
+    case parser::Action::UNHOOK:
+    case parser::Action::PUT:
+      break;
+
+    case parser::Action::PRINT:
+      print(reinterpret_cast<const char *>(&c), 1);
+      break;
+
+    case parser::Action::EXECUTE:
+      emit(Event::EXECUTE, c);
+      break;
+
+    case parser::Action::CLEAR:
+      sequence_.clear();
+      break;
+
+    case parser::Action::COLLECT:
+      sequence_.collect(c);
+      break;
+
+    case parser::Action::PARAM:
+      sequence_.parameters.add(c);
+      break;
+
+    case parser::Action::OSC_START:
+      string_.clear();
+      break;
+
+    case parser::Action::OSC_PUT:
+      string_.put(c);
+      break;
+
+    case parser::Action::CSI_DISPATCH:
+      emit(Event::CSI, c);
+      break;
+
+    case parser::Action::ESC_DISPATCH:
+      emit(Event::ESC, c);
+      break;
+
+    case parser::Action::OSC_END:
+      emit(Event::OSC, c);
+      break;
+
+    default:
+      assert(!"UNREACHABLE");
+      break;
+    }
+  }
+  state_ = transition.state;
+}
+
+void Worker::run() {
+  while (running_.load(std::memory_order_acquire)) {
+    const uint64_t limit = limit_.load(std::memory_order_acquire);
+    if (limit <= buffer_.stats().bytes) {
+      /* backpressure, until the main thread renders what was read */
+      limit_.wait(limit, std::memory_order_acquire);
+      continue;
+    }
+
+    struct pollfd file{.fd = child_, .events = POLLIN, .revents = 0,};
+    /* wakes up periodically to notice it should stop */
+    const int result = ::poll(&file, 1, 100);
+    if (0 > result) {
+      assert(EINTR == errno);
+      continue;
+    } else if (0 == result) {
+      continue;
+    }
+
+    while (running_.load(std::memory_order_relaxed)
+        && limit_.load(std::memory_order_relaxed) > buffer_.stats().bytes) {
+      const ssize_t size = buffer_.read(child_);
+      if (0 > size) {
+        if (EAGAIN == errno) {
+          break;
+        } else if (EIO != errno) {
+          std::cerr << "errno " << errno << " " << strerror(errno) << std::endl;
+        }
+        /* the child is gone */
+        hangup_.store(true, std::memory_order_release);
+        publish();
+        return;
+      } else if (0 == size) {
+        hangup_.store(true, std::memory_order_release);
+        publish();
+        return;
+      }
+
+      if (nullptr != recorder_) {
+        assert(buffer_.front().size() == static_cast<std::size_t>(size));
+        recorder_->write(buffer_.front().data(), size);
+      }
+
+      while ( ! buffer_.empty()) {
+        const std::span<const char> input = buffer_.front();
+        if (parser::State::GROUND == state_) {
+          const std::size_t length = utf8::printable(input.data(), input.size());
+          if (0 < length) {
+            print(input.data(), length);
+            buffer_.consume(length);
+            continue;
+          }
+        }
+
+        if (decoder_.pending()) {
+          /* a control character interrupted a utf-8 sequence */
+          Event & event = open();
+          event.size += decoder_.flush(event.characters.data() + event.size);
+        }
+
+        buffer_.consume(1);
+        handleCharacter(input[0]);
+      }
+
+      publish();
+    }
+
+    if (0 != (file.revents & POLLHUP)) {
+      hangup_.store(true, std::memory_order_release);
+      publish();
+      return;
+    }
+  }
+}
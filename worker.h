@@ -0,0 +1,99 @@
+// Copyright Daniel Morilha 2025
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include <cstdint>
+
+#include "parser.h"
+#include "queue.h"
+#include "recording.h"
+#include "ring.h"
+#include "utf8.h"
+
+/*
+ * Reads the pty and runs the parser on a dedicated thread.
+ *
+ * The grid is owned by the thread doing the rendering, so the worker does
+ * not mutate it, instead it publishes the outcome of parsing as events:
+ * decoded runs of printable characters, executed controls and dispatched
+ * escape sequences, with their parameters already accumulated. The main
+ * thread is woken through an eventfd and applies the events in order.
+ */
+struct Worker {
+  struct Event {
+    enum Type : uint8_t {
+      PRINT,
+      EXECUTE,
+      CSI,
+      ESC,
+      OSC,
+    };
+
+    constexpr static std::size_t CAPACITY = 1024;
+
+    Type type = PRINT;
+    /* final character or the executed control */
+    char c = '\0';
+    uint16_t size = 0;
+    /* pty bytes the event consumed */
+    uint32_t bytes = 0;
+    parser::Sequence sequence;
+    parser::String string;
+    std::array<wchar_t, CAPACITY + 1> characters;
+  };
+
+  using Queue = SPSCQueue<Event, 256>;
+
+  ~Worker();
+  Worker(const int, const std::size_t, recording::Writer * const = nullptr);
+
+  Worker(const Worker &) = delete;
+  Worker & operator = (const Worker &) = delete;
+
+  /* the file descriptor the main thread should poll on */
+  auto fd() const -> int { return eventfd_; }
+  auto hangup() const -> bool { return hangup_.load(std::memory_order_acquire); }
+  auto queue() -> Queue & { return queue_; }
+  auto reads() const -> ReadBuffer::Stats { return buffer_.stats(); }
+
+  /* consumes the wake up notification, called from the main thread */
+  auto acknowledge() -> void;
+  /* how many bytes may be read in total before waiting for a larger limit */
+  auto allow(const uint64_t) -> void;
+
+private:
+  auto claim() -> Event &;
+  auto emit(const Event::Type, const char) -> void;
+  auto handleCharacter(const unsigned char) -> void;
+  auto open() -> Event &;
+  auto print(const char * const, const std::size_t) -> void;
+  auto publish() -> void;
+  auto run() -> void;
+
+  Queue queue_;
+  ReadBuffer buffer_;
+
+  parser::State state_ = parser::State::GROUND;
+  parser::Sequence sequence_;
+  parser::String string_;
+  utf8::Decoder decoder_;
+
+  /* print event being filled, not yet visible to the consumer */
+  Event * open_ = nullptr;
+  Event discard_;
+  /* bytes of controls and sequences the next emitted event accounts for */
+  uint32_t consumed_ = 0;
+
+  std::atomic<uint64_t> limit_ = UINT64_MAX;
+  std::atomic_bool hangup_ = false;
+  std::atomic_bool running_ = true;
+  const int child_ = 0;
+  /* used from the worker thread only */
+  recording::Writer * const recorder_ = nullptr;
+  int eventfd_ = -1;
+  std::thread thread_;
+};